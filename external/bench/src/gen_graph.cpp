@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Generates a clustered graph with a layout, in the DOT format read by kmeans and mapsets
+//
+// The clusters are placed uniformly at random in a square whose area grows with the number of
+// nodes; the nodes of a cluster are normally distributed around its center, and the boxes of
+// the nodes do not overlap (as in a layout made by Graphviz; mapsets requires it). Most edges
+// join two nodes of the same cluster, the others join random nodes. Every node has a position, a
+// size, a label, a cluster and its color, so the graph can be passed to all tools. The output
+// depends only on the options (the random numbers are derived from mt19937 directly, without
+// the standard distributions, whose results differ between the libraries)
+
+struct Options
+{
+	int nodes;
+	double degree;
+	int clusters;
+	// the fraction of the edges inside the clusters
+	double locality;
+	unsigned seed;
+	string output;
+
+	Options(): nodes(1000), degree(4), clusters(10), locality(0.9), seed(1) {}
+};
+
+void Usage()
+{
+	fprintf(stderr, "Usage: gen_graph [options]\n");
+	fprintf(stderr, "Writes a random clustered graph with a layout (to stdout, if no output file is supplied).\n\n");
+	fprintf(stderr, "Allowed options:\n");
+	fprintf(stderr, "  -nodes      The number of nodes (1000, if no value is supplied)\n");
+	fprintf(stderr, "  -degree     The average degree of the nodes (4, if no value is supplied)\n");
+	fprintf(stderr, "  -clusters   The number of clusters (10, if no value is supplied)\n");
+	fprintf(stderr, "  -locality   The fraction of the edges inside the clusters (0.9, if no value is supplied)\n");
+	fprintf(stderr, "  -seed       Seed of the random numbers (1, if no value is supplied)\n");
+	fprintf(stderr, "  -o          Output file name\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string s(argv[i]);
+		size_t eq = s.find('=');
+		string name = s.substr(0, eq);
+		string value = (eq == string::npos ? "" : s.substr(eq + 1));
+		if (value.empty())
+		{
+			fprintf(stderr, "no value of option \"%s\"\n", name.c_str());
+			return false;
+		}
+
+		if (name == "-nodes")
+			options.nodes = atoi(value.c_str());
+		else if (name == "-degree")
+			options.degree = atof(value.c_str());
+		else if (name == "-clusters")
+			options.clusters = atoi(value.c_str());
+		else if (name == "-locality")
+			options.locality = atof(value.c_str());
+		else if (name == "-seed")
+			options.seed = (unsigned)strtoul(value.c_str(), NULL, 10);
+		else if (name == "-o")
+			options.output = value;
+		else
+		{
+			fprintf(stderr, "unrecognized option \"%s\"\n", name.c_str());
+			return false;
+		}
+	}
+
+	if (options.nodes < 2 || options.clusters < 1 || options.clusters > options.nodes || options.degree < 0 ||
+		options.locality < 0 || options.locality > 1)
+	{
+		fprintf(stderr, "invalid values of the options\n");
+		return false;
+	}
+
+	return true;
+}
+
+class Random
+{
+	mt19937 rnd;
+
+public:
+	explicit Random(unsigned seed): rnd(seed) {}
+
+	// uniform in [0, 1)
+	double next()
+	{
+		return rnd() / 4294967296.0;
+	}
+
+	// uniform in [0, n)
+	int next(int n)
+	{
+		return min((int)(next() * n), n - 1);
+	}
+
+	// standard normal (Box-Muller)
+	double gaussian()
+	{
+		double u = 1.0 - next();
+		double v = next();
+		return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+	}
+};
+
+// The boxes of the placed nodes, hashed into square cells (larger than the boxes with the gap)
+class Placement
+{
+	static const double Height;
+	static const double Gap;
+	static const double CellSize;
+
+	vector<double> xs, ys, halfWidths;
+	unordered_map<long long, vector<int> > cells;
+
+public:
+	bool overlaps(double x, double y, double halfWidth) const
+	{
+		long long cx = Cell(x), cy = Cell(y);
+		for (long long i = cx - 1; i <= cx + 1; i++)
+			for (long long j = cy - 1; j <= cy + 1; j++)
+			{
+				auto it = cells.find(Key(i, j));
+				if (it == cells.end()) continue;
+
+				for (int k : it->second)
+					if (fabs(x - xs[k]) < halfWidth + halfWidths[k] + Gap && fabs(y - ys[k]) < Height + Gap)
+						return true;
+			}
+
+		return false;
+	}
+
+	void add(double x, double y, double halfWidth)
+	{
+		cells[Key(Cell(x), Cell(y))].push_back((int)xs.size());
+		xs.push_back(x);
+		ys.push_back(y);
+		halfWidths.push_back(halfWidth);
+	}
+
+private:
+	static long long Cell(double x)
+	{
+		return (long long)floor(x / CellSize);
+	}
+
+	static long long Key(long long cx, long long cy)
+	{
+		return (long long)(((unsigned long long)cx << 32) ^ (unsigned long long)(unsigned int)cy);
+	}
+};
+
+// in points (the widths are in inches, as in the DOT format)
+const double Placement::Height = 0.3 * 72;
+const double Placement::Gap = 10;
+const double Placement::CellSize = 0.9 * 72 + Placement::Gap;
+
+// a color of the cluster; the hues are spread by the golden ratio
+string ClusterColor(int cluster)
+{
+	double h = fmod(cluster * 0.618033988749895, 1.0) * 6.0;
+	double s = 0.55, v = 0.9;
+	int sector = (int)h;
+	double f = h - sector;
+	double p = v * (1 - s), q = v * (1 - s * f), t = v * (1 - s * (1 - f));
+	double rgb[6][3] = {{v, t, p}, {q, v, p}, {p, v, t}, {p, q, v}, {t, p, v}, {v, p, q}};
+
+	char buf[16];
+	sprintf(buf, "#%02x%02x%02x", (int)(rgb[sector][0] * 255), (int)(rgb[sector][1] * 255), (int)(rgb[sector][2] * 255));
+	return buf;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 1;
+	}
+
+	Random rnd(options.seed);
+	int n = options.nodes;
+	int k = options.clusters;
+
+	// the nodes per unit of area are the same for all sizes
+	double side = 100.0 * sqrt((double)n);
+	double spread = 0.3 * side / sqrt((double)k);
+	vector<double> cx(k), cy(k);
+	for (int c = 0; c < k; c++)
+	{
+		cx[c] = side * rnd.next();
+		cy[c] = side * rnd.next();
+	}
+
+	// every cluster has at least one node
+	vector<int> cluster(n);
+	vector<vector<int> > members(k);
+	for (int i = 0; i < n; i++)
+	{
+		cluster[i] = (i < k ? i : rnd.next(k));
+		members[cluster[i]].push_back(i);
+	}
+
+	// the positions overlapping the placed nodes are drawn again, farther from the center
+	vector<double> x(n), y(n), width(n);
+	Placement placement;
+	for (int i = 0; i < n; i++)
+	{
+		width[i] = 0.3 + 0.6 * rnd.next();
+		double halfWidth = width[i] * 72 / 2;
+		for (int attempt = 0; ; attempt++)
+		{
+			double scale = spread * (1.0 + attempt / 10.0);
+			x[i] = cx[cluster[i]] + scale * rnd.gaussian();
+			y[i] = cy[cluster[i]] + scale * rnd.gaussian();
+			if (!placement.overlaps(x[i], y[i], halfWidth)) break;
+		}
+		placement.add(x[i], y[i], halfWidth);
+	}
+
+	// the edges without loops and multiple edges; the attempts are limited for dense graphs
+	long long m = min((long long)llround(options.degree * n / 2), (long long)n * (n - 1) / 2);
+	vector<pair<int, int> > edges;
+	unordered_set<long long> used;
+	for (long long attempt = 0; (long long)edges.size() < m && attempt < 10 * m; attempt++)
+	{
+		int u = rnd.next(n);
+		int v;
+		if (rnd.next() < options.locality)
+		{
+			const vector<int>& same = members[cluster[u]];
+			v = same[rnd.next((int)same.size())];
+		}
+		else
+			v = rnd.next(n);
+
+		if (u == v) continue;
+		if (u > v) swap(u, v);
+		if (!used.insert((long long)u * n + v).second) continue;
+
+		edges.push_back(make_pair(u, v));
+	}
+
+	FILE* f = stdout;
+	if (!options.output.empty())
+	{
+		f = fopen(options.output.c_str(), "w");
+		if (f == NULL)
+		{
+			fprintf(stderr, "cannot open file \"%s\"\n", options.output.c_str());
+			return 1;
+		}
+	}
+
+	double xl = *min_element(x.begin(), x.end()), xr = *max_element(x.begin(), x.end());
+	double yl = *min_element(y.begin(), y.end()), yr = *max_element(y.begin(), y.end());
+
+	fprintf(f, "graph {\n");
+	fprintf(f, "  graph [bb=\"%.2f,%.2f,%.2f,%.2f\"];\n", xl - 50, yl - 50, xr + 50, yr + 50);
+	fprintf(f, "  node [label=\"\\N\", shape=box];\n");
+	for (int i = 0; i < n; i++)
+	{
+		fprintf(f, "  \"n%d\" [pos=\"%.2f,%.2f\", width=\"%.2f\", height=\"0.30\", label=\"node %d\", cluster=\"%d\", clustercolor=\"%s\"];\n",
+			i, x[i], y[i], width[i], i, cluster[i] + 1, ClusterColor(cluster[i]).c_str());
+	}
+	for (int i = 0; i < (int)edges.size(); i++)
+		fprintf(f, "  \"n%d\" -- \"n%d\";\n", edges[i].first, edges[i].second);
+	fprintf(f, "}\n");
+
+	if (f != stdout) fclose(f);
+	return 0;
+}
@@ -0,0 +1,285 @@
+#include "distances/graph_distances.h"
+
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <cassert>
+
+#include "profile/profile.h"
+
+namespace distances {
+
+// the same as in the common files of the tools
+const double INF = 123456789.0;
+
+// the single-source (and multi-source) runs of all instances
+static profile::Counter DijkstraRuns("dijkstra_runs");
+
+size_t GraphDistances::DefaultMemoryBudget = (size_t)1024 * 1024 * 1024;
+
+GraphDistances::GraphDistances(const CSRGraph& graph, size_t memoryBudget, bool allowApproximation): graph(graph)
+{
+	n = graph.nodeCount();
+	runCount = 0;
+
+	unitWeights = true;
+	for (int i = 0; i < (int)graph.weight.size(); i++)
+		if (graph.weight[i] != 1.0) unitWeights = false;
+
+	size_t rowBytes = std::max((size_t)1, (size_t)n * sizeof(float));
+	size_t fitRows = memoryBudget / rowBytes;
+	blockRows = (int)std::min((size_t)std::max(n, 1), std::max((size_t)1, fitRows));
+
+	if (fitRows >= (size_t)n)
+	{
+		mode = FULL;
+	}
+	else if (allowApproximation && fitRows >= 2)
+	{
+		mode = PIVOTS;
+		// keep half of the budget for pivots and half for blocks
+		blockRows = std::max(1, blockRows / 2);
+		initPivots(std::min(64, std::max(1, (int)fitRows / 2)));
+	}
+	else
+	{
+		mode = ON_DEMAND;
+	}
+
+	rows = std::vector<std::vector<float> >(n);
+	cachedPosition = std::vector<std::list<int>::iterator>(n, cachedRows.end());
+}
+
+void GraphDistances::singleSourceBFS(int s, std::vector<int>& queue, float* row) const
+{
+	for (int i = 0; i < n; i++)
+		row[i] = -1.0f;
+	row[s] = 0;
+
+	queue.resize(n);
+	int head = 0, tail = 0;
+	queue[tail++] = s;
+
+	while (head < tail)
+	{
+		int v = queue[head++];
+		for (int i = graph.offset[v]; i < graph.offset[v + 1]; i++)
+		{
+			int next = graph.target[i];
+			if (row[next] >= 0) continue;
+
+			row[next] = row[v] + 1;
+			queue[tail++] = next;
+		}
+	}
+}
+
+void GraphDistances::singleSource(int s, std::vector<double>& dist, float* row) const
+{
+	if (unitWeights)
+	{
+		std::vector<int> queue;
+		singleSourceBFS(s, queue, row);
+		return;
+	}
+
+	dist.assign(n, INF);
+	dist[s] = 0;
+
+	typedef std::pair<double, int> QE;
+	std::priority_queue<QE, std::vector<QE>, std::greater<QE> > q;
+	q.push(std::make_pair(0.0, s));
+
+	while (!q.empty())
+	{
+		QE now = q.top();
+		q.pop();
+
+		int v = now.second;
+		if (now.first > dist[v]) continue;
+
+		for (int i = graph.offset[v]; i < graph.offset[v + 1]; i++)
+		{
+			int next = graph.target[i];
+			double nd = dist[v] + graph.weight[i];
+			if (dist[next] > nd)
+			{
+				dist[next] = nd;
+				q.push(std::make_pair(nd, next));
+			}
+		}
+	}
+
+	for (int i = 0; i < n; i++)
+		row[i] = (dist[i] < INF ? (float)dist[i] : -1.0f);
+}
+
+void GraphDistances::computeBlock(const std::vector<int>& sources, std::vector<float>& block)
+{
+	int k = (int)sources.size();
+	block.resize((size_t)k * n);
+
+	#pragma omp parallel
+	{
+		std::vector<double> dist;
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < k; i++)
+			singleSource(sources[i], dist, &block[(size_t)i * n]);
+	}
+
+	runCount += k;
+	DijkstraRuns.add(k);
+}
+
+void GraphDistances::touchRow(int s)
+{
+	//all rows are kept, so the order of use is not needed
+	if (mode == FULL) return;
+
+	if (cachedPosition[s] != cachedRows.end())
+		cachedRows.erase(cachedPosition[s]);
+
+	cachedRows.push_front(s);
+	cachedPosition[s] = cachedRows.begin();
+
+	//evict the least recently used row
+	if ((int)cachedRows.size() > blockRows)
+	{
+		int last = cachedRows.back();
+		cachedRows.pop_back();
+		cachedPosition[last] = cachedRows.end();
+		std::vector<float>().swap(rows[last]);
+	}
+}
+
+const float* GraphDistances::getRow(int s)
+{
+	assert(0 <= s && s < n);
+	if (rows[s].empty())
+	{
+		rows[s].resize(n);
+		std::vector<double> dist;
+		singleSource(s, dist, &rows[s][0]);
+		runCount++;
+		DijkstraRuns.add();
+	}
+
+	touchRow(s);
+	return &rows[s][0];
+}
+
+double GraphDistances::getDistance(int s, int t)
+{
+	if (s == t) return 0;
+
+	//the graph is undirected, so any of the two rows can be used
+	if (!rows[s].empty())
+	{
+		touchRow(s);
+		return rows[s][t];
+	}
+	if (!rows[t].empty())
+	{
+		touchRow(t);
+		return rows[t][s];
+	}
+
+	if (mode == PIVOTS)
+	{
+		double best = -1;
+		for (int i = 0; i < (int)pivots.size(); i++)
+		{
+			float ds = pivotRows[(size_t)i * n + s];
+			float dt = pivotRows[(size_t)i * n + t];
+			if (ds < 0 || dt < 0) continue;
+
+			if (best == -1 || best > ds + dt)
+				best = ds + dt;
+		}
+
+		if (best != -1) return best;
+	}
+
+	return getRow(s)[t];
+}
+
+void GraphDistances::initPivots(int count)
+{
+	//farthest-first traversal; unreachable nodes are the farthest
+	std::vector<double> minDist(n, INF);
+	int next = 0;
+	for (int i = 0; i < count && i < n; i++)
+	{
+		pivots.push_back(next);
+		pivotRows.resize((size_t)pivots.size() * n);
+
+		std::vector<double> dist;
+		float* row = &pivotRows[(size_t)i * n];
+		singleSource(next, dist, row);
+		runCount++;
+		DijkstraRuns.add();
+
+		double farthest = -1;
+		for (int v = 0; v < n; v++)
+		{
+			double d = (row[v] < 0 ? 2 * INF : row[v]);
+			minDist[v] = std::min(minDist[v], d);
+			if (farthest < minDist[v])
+			{
+				farthest = minDist[v];
+				next = v;
+			}
+		}
+
+		if (farthest <= 0) break;
+	}
+}
+
+void GraphDistances::multiSourceDistances(const std::vector<int>& sources, std::vector<double>& dist, std::vector<int>& closest)
+{
+	dist.assign(n, INF);
+	closest.assign(n, -1);
+
+	//entries are (distance, source position, node)
+	typedef std::pair<double, std::pair<int, int> > QE;
+	std::priority_queue<QE, std::vector<QE>, std::greater<QE> > q;
+	for (int i = 0; i < (int)sources.size(); i++)
+	{
+		int s = sources[i];
+		if (closest[s] != -1) continue;
+
+		dist[s] = 0;
+		closest[s] = i;
+		q.push(std::make_pair(0.0, std::make_pair(i, s)));
+	}
+
+	while (!q.empty())
+	{
+		QE now = q.top();
+		q.pop();
+
+		int v = now.second.second;
+		int src = now.second.first;
+		if (now.first > dist[v] || src != closest[v]) continue;
+
+		for (int i = graph.offset[v]; i < graph.offset[v + 1]; i++)
+		{
+			int next = graph.target[i];
+			double nd = dist[v] + graph.weight[i];
+			if (dist[next] > nd || (dist[next] == nd && closest[next] > src))
+			{
+				dist[next] = nd;
+				closest[next] = src;
+				q.push(std::make_pair(nd, std::make_pair(src, next)));
+			}
+		}
+	}
+
+	for (int i = 0; i < n; i++)
+		if (dist[i] >= INF) dist[i] = -1;
+
+	runCount++;
+	DijkstraRuns.add();
+}
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <cstddef>
+
+namespace distances {
+
+// Compressed sparse row representation of an undirected weighted graph
+struct CSRGraph
+{
+	// neighbors of node v are target[offset[v]] .. target[offset[v + 1] - 1]
+	std::vector<int> offset;
+	std::vector<int> target;
+	std::vector<double> weight;
+
+	int nodeCount() const
+	{
+		return (int)offset.size() - 1;
+	}
+};
+
+// Shortest-path distances on a graph
+//
+// Distances from a source are stored as a row of floats (-1 for unreachable nodes).
+// If all n rows fit into the memory budget, rows are computed on first use and kept forever;
+// otherwise only a bounded number of rows is cached and, if approximation is allowed,
+// random queries are answered through a small set of pivots: d(s, t) <= min_p d(s, p) + d(p, t).
+// Rows of graphs with unit edge lengths are computed by BFS, others by Dijkstra
+class GraphDistances
+{
+	GraphDistances(const GraphDistances&);
+	GraphDistances& operator = (const GraphDistances&);
+
+public:
+	enum Mode { FULL, ON_DEMAND, PIVOTS };
+
+	GraphDistances(const CSRGraph& graph, size_t memoryBudget, bool allowApproximation);
+
+	inline Mode getMode() const
+	{
+		return mode;
+	}
+
+	inline int nodeCount() const
+	{
+		return n;
+	}
+
+	// the number of rows that can be kept in memory at once
+	inline int maxBlockRows() const
+	{
+		return blockRows;
+	}
+
+	// the number of single-source runs performed so far
+	inline long long getRunCount() const
+	{
+		return runCount;
+	}
+
+	// distance between s and t, or -1 if the nodes are not connected;
+	// not thread-safe, for the same reasons as getRow
+	double getDistance(int s, int t);
+
+	// distances from s to all nodes; the pointer is valid until the next call.
+	// Not thread-safe: the row is computed into and moved within the shared cache, so it must not
+	// be called from a parallel loop (use computeBlock, forEachBlock or forEachRow instead)
+	const float* getRow(int s);
+
+	// computes rows for the given sources in parallel;
+	// the result is a row-major block of size |sources| x n
+	void computeBlock(const std::vector<int>& sources, std::vector<float>& block);
+
+	// for every node, the distance to the closest source (-1 if unreachable) and
+	// the index of that source in sources (ties are broken by the smaller index)
+	void multiSourceDistances(const std::vector<int>& sources, std::vector<double>& dist, std::vector<int>& closest);
+
+	// calls f(first, rows) for consecutive blocks of sources, where rows[k] holds
+	// the distances from sources[first + k]; missing rows are computed in parallel
+	template<class F>
+	void forEachBlock(const std::vector<int>& sources, F f)
+	{
+		std::vector<const float*> rowPtrs;
+		if (mode == FULL)
+		{
+			std::vector<int> missing;
+			for (int i = 0; i < (int)sources.size(); i++)
+				if (rows[sources[i]].empty()) missing.push_back(sources[i]);
+
+			for (int i = 0; i < (int)missing.size(); i += blockRows)
+			{
+				std::vector<int> part(missing.begin() + i, missing.begin() + std::min((int)missing.size(), i + blockRows));
+				std::vector<float> block;
+				computeBlock(part, block);
+				for (int k = 0; k < (int)part.size(); k++)
+					rows[part[k]].assign(block.begin() + (size_t)k * n, block.begin() + (size_t)(k + 1) * n);
+			}
+
+			for (int k = 0; k < (int)sources.size(); k++)
+				rowPtrs.push_back(&rows[sources[k]][0]);
+			f(0, rowPtrs);
+			return;
+		}
+
+		std::vector<float> block;
+		for (int i = 0; i < (int)sources.size(); i += blockRows)
+		{
+			std::vector<int> part(sources.begin() + i, sources.begin() + std::min((int)sources.size(), i + blockRows));
+			computeBlock(part, block);
+
+			rowPtrs.clear();
+			for (int k = 0; k < (int)part.size(); k++)
+				rowPtrs.push_back(&block[(size_t)k * n]);
+			f(i, rowPtrs);
+		}
+	}
+
+	// calls f(k, row) for every sources[k], computing the missing rows in parallel blocks
+	template<class F>
+	void forEachRow(const std::vector<int>& sources, F f)
+	{
+		forEachBlock(sources, [&](int first, const std::vector<const float*>& rowPtrs)
+		{
+			for (int k = 0; k < (int)rowPtrs.size(); k++)
+				f(first + k, rowPtrs[k]);
+		});
+	}
+
+	static size_t DefaultMemoryBudget;
+
+private:
+	CSRGraph graph;
+	int n;
+	Mode mode;
+	int blockRows;
+	long long runCount;
+	bool unitWeights;
+
+	// cached rows (empty if not computed) and their order of use (not kept in the FULL mode)
+	std::vector<std::vector<float> > rows;
+	std::list<int> cachedRows;
+	std::vector<std::list<int>::iterator> cachedPosition;
+
+	// distances from the pivots, row-major
+	std::vector<int> pivots;
+	std::vector<float> pivotRows;
+
+	void initPivots(int count);
+	void singleSource(int s, std::vector<double>& dist, float* row) const;
+	void singleSourceBFS(int s, std::vector<int>& queue, float* row) const;
+	void touchRow(int s);
+};
+
+}
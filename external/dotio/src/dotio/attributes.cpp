@@ -0,0 +1,228 @@
+#include "dotio/attributes.h"
+
+#include <unordered_map>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+
+namespace dotio {
+
+namespace {
+
+//in the order of HotKey
+const char* const HOT_KEYS[HOT_KEY_COUNT] = {"pos", "width", "height", "cluster", "clustercolor", "len", "weight"};
+
+typedef std::unordered_map<StrRef, int, StrRefHash> HotKeyTable;
+
+//the table is never changed after its construction, so the lookups need no locking
+const HotKeyTable& HotKeys()
+{
+	static const HotKeyTable table = []()
+	{
+		HotKeyTable t;
+		for (int i = 0; i < HOT_KEY_COUNT; i++)
+			t[StrRef(HOT_KEYS[i], (int)strlen(HOT_KEYS[i]))] = i;
+		return t;
+	}();
+	return table;
+}
+
+bool isNumeric(int key)
+{
+	return key == KEY_POS || key == KEY_WIDTH || key == KEY_HEIGHT || key == KEY_LEN || key == KEY_WEIGHT;
+}
+
+//strtod on a terminated copy of the text, since views are not terminated
+double parseDouble(const char*& p, const char* end)
+{
+	char buf[64];
+	int len = (int)(end - p);
+	if (len > 63) len = 63;
+	memcpy(buf, p, len);
+	buf[len] = 0;
+
+	char* stop;
+	double value = strtod(buf, &stop);
+	p += (stop - buf);
+	return value;
+}
+
+//"x,y" (the separator is an arbitrary character)
+void parsePoint(const StrRef& s, double& x, double& y)
+{
+	const char* p = s.begin();
+	x = parseDouble(p, s.end());
+	while (p < s.end() && isspace(*p)) p++;
+	if (p < s.end()) p++;
+	y = parseDouble(p, s.end());
+}
+
+}
+
+int FindHotKey(const StrRef& name)
+{
+	const HotKeyTable& table = HotKeys();
+	HotKeyTable::const_iterator it = table.find(name);
+	return (it != table.end() ? it->second : -1);
+}
+
+StrRef HotKeyName(int key)
+{
+	assert(0 <= key && key < HOT_KEY_COUNT);
+	return StrRef(HOT_KEYS[key], (int)strlen(HOT_KEYS[key]));
+}
+
+int Attributes::find(int key) const
+{
+	for (int i = 0; i < (int)entries.size(); i++)
+		if (entries[i].key == key) return i;
+	return -1;
+}
+
+int Attributes::find(const StrRef& name) const
+{
+	int key = FindHotKey(name);
+	return (key != -1 ? find(key) : findOther(name));
+}
+
+int Attributes::findOther(const StrRef& name) const
+{
+	for (int i = 0; i < (int)entries.size(); i++)
+		if (entries[i].key == -1 && entryName(entries[i]) == name) return i;
+	return -1;
+}
+
+Attributes::Entry& Attributes::insert(int key, const StrRef& name, bool ownName)
+{
+	int i = (key != -1 ? find(key) : findOther(name));
+	if (i != -1) return entries[i];
+
+	//attributes usually come in the alphabetical order
+	i = (int)entries.size();
+	while (i > 0 && name < entryName(entries[i - 1])) i--;
+
+	Entry e;
+	e.key = key;
+	e.ownedName = -1;
+	e.owned = -1;
+	e.name = name;
+	e.number[0] = e.number[1] = 0;
+	if (ownName)
+	{
+		e.ownedName = (int)ownedValues.size();
+		ownedValues.push_back(name.str());
+		e.name = StrRef();
+	}
+
+	if (entries.empty())
+		entries.reserve(8);
+	entries.insert(entries.begin() + i, e);
+	return entries[i];
+}
+
+void Attributes::setValue(Entry& e, const std::string& value)
+{
+	if (e.owned == -1)
+	{
+		e.owned = (int)ownedValues.size();
+		ownedValues.push_back(value);
+	}
+	else
+	{
+		ownedValues[e.owned] = value;
+	}
+	e.view = StrRef();
+	parseNumbers(e);
+}
+
+void Attributes::parseNumbers(Entry& e) const
+{
+	if (e.key == KEY_POS)
+		parsePoint(entryValue(e), e.number[0], e.number[1]);
+	else if (isNumeric(e.key))
+	{
+		StrRef s = entryValue(e);
+		const char* p = s.begin();
+		e.number[0] = parseDouble(p, s.end());
+	}
+}
+
+StrRef Attributes::get(int key) const
+{
+	int i = find(key);
+	if (i == -1) return StrRef();
+	return entryValue(entries[i]);
+}
+
+StrRef Attributes::get(const StrRef& name) const
+{
+	int i = find(name);
+	if (i == -1) return StrRef();
+	return entryValue(entries[i]);
+}
+
+void Attributes::setView(const StrRef& name, const StrRef& value)
+{
+	int key = FindHotKey(name);
+	Entry& e = insert(key, (key != -1 ? HotKeyName(key) : name), false);
+	if (e.owned != -1)
+		ownedValues[e.owned].clear();
+	e.view = value;
+	e.owned = -1;
+	parseNumbers(e);
+}
+
+void Attributes::set(int key, const std::string& value)
+{
+	setValue(insert(key, HotKeyName(key), false), value);
+}
+
+void Attributes::set(const StrRef& name, const std::string& value)
+{
+	int key = FindHotKey(name);
+	if (key != -1)
+		set(key, value);
+	else
+		setValue(insert(-1, name, true), value);
+}
+
+void Attributes::removeAt(int i)
+{
+	if (i == -1) return;
+
+	if (entries[i].owned != -1)
+		ownedValues[entries[i].owned].clear();
+	if (entries[i].ownedName != -1)
+		ownedValues[entries[i].ownedName].clear();
+	entries.erase(entries.begin() + i);
+}
+
+double Attributes::doubleAt(int i) const
+{
+	if (i == -1) return 0;
+	if (isNumeric(entries[i].key)) return entries[i].number[0];
+
+	StrRef s = entryValue(entries[i]);
+	const char* p = s.begin();
+	return parseDouble(p, s.end());
+}
+
+void Attributes::pointAt(int i, double& x, double& y) const
+{
+	if (i == -1)
+	{
+		x = y = 0;
+		return;
+	}
+
+	if (entries[i].key == KEY_POS)
+	{
+		x = entries[i].number[0];
+		y = entries[i].number[1];
+		return;
+	}
+
+	parsePoint(entryValue(entries[i]), x, y);
+}
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "dotio/str_ref.h"
+
+#include <string>
+#include <vector>
+
+namespace dotio {
+
+// The frequently used (hot) attribute keys have fixed ids; other keys are kept by name in
+// the attributes themselves, so that no table grows with the keys of the inputs
+enum HotKey
+{
+	KEY_POS,
+	KEY_WIDTH,
+	KEY_HEIGHT,
+	KEY_CLUSTER,
+	KEY_CLUSTERCOLOR,
+	KEY_LEN,
+	KEY_WEIGHT,
+	HOT_KEY_COUNT
+};
+
+// id of the hot key, or -1 if the key is not hot
+int FindHotKey(const StrRef& name);
+
+StrRef HotKeyName(int key);
+
+// Attributes of a node, an edge, or a style entry
+//
+// Names and values are views of the input buffer, or owned strings if they are set by the program.
+// Numeric hot attributes (pos, width, height, len and weight) are parsed once, when they are set
+class Attributes
+{
+	struct Entry
+	{
+		// id of a hot key, or -1
+		int key;
+		// indices of the name and the value in ownedValues, or -1 if they are views
+		int ownedName;
+		int owned;
+		StrRef name;
+		StrRef view;
+		// parsed value of a numeric hot attribute; pos is a pair of numbers
+		double number[2];
+	};
+
+	// sorted by the names of the keys, that is, in the order of writing
+	std::vector<Entry> entries;
+	// names and values set by the program
+	std::vector<std::string> ownedValues;
+
+	StrRef entryName(const Entry& e) const
+	{
+		return e.ownedName == -1 ? e.name : StrRef(ownedValues[e.ownedName]);
+	}
+
+	StrRef entryValue(const Entry& e) const
+	{
+		return e.owned == -1 ? e.view : StrRef(ownedValues[e.owned]);
+	}
+
+	int find(int key) const;
+	int find(const StrRef& name) const;
+	// the entry of a key that is not hot
+	int findOther(const StrRef& name) const;
+	Entry& insert(int key, const StrRef& name, bool ownName);
+	void setValue(Entry& e, const std::string& value);
+	void parseNumbers(Entry& e) const;
+	void removeAt(int i);
+	double doubleAt(int i) const;
+	void pointAt(int i, double& x, double& y) const;
+
+public:
+	int size() const
+	{
+		return (int)entries.size();
+	}
+
+	// the i-th attribute in the alphabetical order of the keys
+	StrRef name(int i) const
+	{
+		return entryName(entries[i]);
+	}
+
+	StrRef value(int i) const
+	{
+		return entryValue(entries[i]);
+	}
+
+	bool has(int key) const
+	{
+		return find(key) != -1;
+	}
+
+	bool has(const StrRef& name) const
+	{
+		return find(name) != -1;
+	}
+
+	// empty if there is no such attribute
+	StrRef get(int key) const;
+	StrRef get(const StrRef& name) const;
+
+	// the viewed texts of the name and the value must outlive the attributes
+	void setView(const StrRef& name, const StrRef& value);
+
+	void set(int key, const std::string& value);
+	void set(const StrRef& name, const std::string& value);
+
+	void remove(int key)
+	{
+		removeAt(find(key));
+	}
+
+	void remove(const StrRef& name)
+	{
+		removeAt(find(name));
+	}
+
+	void clear()
+	{
+		entries.clear();
+		ownedValues.clear();
+	}
+
+	void swap(Attributes& o)
+	{
+		entries.swap(o.entries);
+		ownedValues.swap(o.ownedValues);
+	}
+
+	// value of a numeric attribute; 0 if there is no such attribute or it is not a number
+	double getDouble(int key) const
+	{
+		return doubleAt(find(key));
+	}
+
+	double getDouble(const StrRef& name) const
+	{
+		return doubleAt(find(name));
+	}
+
+	// value of a point attribute "x,y"
+	void getPoint(int key, double& x, double& y) const
+	{
+		pointAt(find(key), x, y);
+	}
+
+	void getPoint(const StrRef& name, double& x, double& y) const
+	{
+		pointAt(find(name), x, y);
+	}
+};
+
+}
@@ -0,0 +1,245 @@
+#include "dotio/dot_reader.h"
+
+#include <iostream>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dotio {
+
+namespace {
+
+bool isSpace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+StrRef trim(const StrRef& s)
+{
+	const char* i = s.begin();
+	const char* j = s.end();
+	while (i < j && isSpace(*i)) i++;
+	while (j > i && isSpace(*(j - 1))) j--;
+	return StrRef(i, j);
+}
+
+StrRef extractId(const StrRef& line)
+{
+	StrRef s = trim(line);
+	if (s.length >= 2 && s.data[0] == '"' && s.data[s.length - 1] == '"')
+		return StrRef(s.data + 1, s.length - 2);
+
+	return s;
+}
+
+//position of the closing quote for the text starting after an opening quote, or end
+const char* skipQuoted(const char* p, const char* end)
+{
+	while (true)
+	{
+		const char* q = (const char*)memchr(p, '"', end - p);
+		if (q == NULL) return end;
+
+		//the quote is escaped if it follows an odd number of backslashes
+		int slashes = 0;
+		while (q - slashes > p && *(q - slashes - 1) == '\\') slashes++;
+		if (slashes % 2 == 0) return q;
+		p = q + 1;
+	}
+}
+
+//position of the first separator outside quotes, or end
+const char* findOutsideQuotes(const char* p, const char* end, char separator)
+{
+	for (; p < end; p++)
+	{
+		if (*p == '"')
+		{
+			p = skipQuoted(p + 1, end);
+			if (p == end) break;
+		}
+		else if (*p == separator) break;
+	}
+
+	return p;
+}
+
+//position of the first '--' outside quotes, or end
+const char* findEdgeOp(const char* p, const char* end)
+{
+	while (true)
+	{
+		p = findOutsideQuotes(p, end, '-');
+		if (p + 1 >= end) return end;
+		if (p[1] == '-') return p;
+		p++;
+	}
+}
+
+void readStream(FILE* f, std::vector<char>& storage)
+{
+	const size_t CHUNK = 1 << 20;
+	size_t length = 0;
+	while (true)
+	{
+		//resize does not grow the capacity geometrically
+		if (storage.capacity() < length + CHUNK)
+			storage.reserve(2 * (length + CHUNK));
+		storage.resize(length + CHUNK);
+		size_t cnt = fread(&storage[length], 1, CHUNK, f);
+		length += cnt;
+		if (cnt < CHUNK) break;
+	}
+	storage.resize(length);
+}
+
+}
+
+DotBuffer::~DotBuffer()
+{
+#ifndef _WIN32
+	if (mapped)
+		munmap((void*)data, length);
+#endif
+}
+
+std::shared_ptr<DotBuffer> DotBuffer::Load(const std::string& filename)
+{
+	std::shared_ptr<DotBuffer> buffer(new DotBuffer());
+	if (filename == "")
+	{
+		readStream(stdin, buffer->storage);
+	}
+	else
+	{
+#ifndef _WIN32
+		int fd = open(filename.c_str(), O_RDONLY);
+		struct stat st;
+		if (fd != -1 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+		{
+			void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				madvise(p, st.st_size, MADV_SEQUENTIAL);
+				buffer->data = (const char*)p;
+				buffer->length = st.st_size;
+				buffer->mapped = true;
+			}
+		}
+		if (fd != -1)
+			close(fd);
+		if (buffer->mapped)
+			return buffer;
+#endif
+
+		FILE* f = fopen(filename.c_str(), "rb");
+		if (f == NULL)
+		{
+			std::cerr << "can't open input file '" << filename << "'" << std::endl;
+			throw 1;
+		}
+		readStream(f, buffer->storage);
+		fclose(f);
+	}
+
+	buffer->length = buffer->storage.size();
+	buffer->data = (buffer->length > 0 ? &buffer->storage[0] : "");
+	return buffer;
+}
+
+std::shared_ptr<DotBuffer> DotBuffer::Take(std::vector<char>& text)
+{
+	std::shared_ptr<DotBuffer> buffer(new DotBuffer());
+	buffer->storage.swap(text);
+
+	buffer->length = buffer->storage.size();
+	buffer->data = (buffer->length > 0 ? &buffer->storage[0] : "");
+	return buffer;
+}
+
+void DotParser::Parse(const char* begin, const char* end)
+{
+	//statements are the parts of the text inside braces separated by semicolons
+	const char* p = findOutsideQuotes(begin, end, '{');
+	while (p < end)
+	{
+		const char* start = p + 1;
+		const char* q = start;
+		for (; q < end; q++)
+		{
+			if (*q == '"')
+			{
+				q = skipQuoted(q + 1, end);
+				if (q == end) break;
+			}
+			else if (*q == ';' || *q == '{' || *q == '}') break;
+		}
+
+		if (q < end && *q == ';')
+			ParseStatement(StrRef(start, q));
+
+		if (q < end && *q == '}')
+			p = findOutsideQuotes(q, end, '{');
+		else
+			p = q;
+	}
+}
+
+void DotParser::ParseStatement(const StrRef& line)
+{
+	const char* open = findOutsideQuotes(line.begin(), line.end(), '[');
+	StrRef beforeBrackets(line.begin(), open);
+	StrRef insideBrackets;
+	if (open < line.end())
+	{
+		const char* close = findOutsideQuotes(open + 1, line.end(), ']');
+		insideBrackets = StrRef(open + 1, close);
+	}
+
+	StrRef s = trim(beforeBrackets);
+	if (s.empty()) return;
+
+	attr.clear();
+	ParseAttr(insideBrackets);
+
+	if (s == StrRef("node", 4) || s == StrRef("graph", 5) || s == StrRef("edge", 4))
+	{
+		handler.style(s, attr);
+		return;
+	}
+
+	const char* op = findEdgeOp(s.begin(), s.end());
+	if (op < s.end())
+		handler.edge(extractId(StrRef(s.begin(), op)), extractId(StrRef(op + 2, s.end())), attr);
+	else
+		handler.node(extractId(s), attr);
+}
+
+void DotParser::ParseAttr(const StrRef& line)
+{
+	const char* p = line.begin();
+	while (p < line.end())
+	{
+		const char* next = findOutsideQuotes(p, line.end(), ',');
+		StrRef item = trim(StrRef(p, next));
+		p = next + 1;
+		if (item.empty()) continue;
+
+		const char* eq = findOutsideQuotes(item.begin(), item.end(), '=');
+		if (eq == item.end())
+		{
+			std::cerr << "Unknown attribute: " << item.str() << "\n";
+			continue;
+		}
+
+		StrRef key = trim(StrRef(item.begin(), eq));
+		attr.setView(key, extractId(StrRef(eq + 1, item.end())));
+	}
+}
+
+}
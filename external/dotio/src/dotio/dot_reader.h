@@ -0,0 +1,83 @@
+#pragma once
+
+#include "dotio/attributes.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dotio {
+
+// Contents of an input file; memory-mapped if possible
+class DotBuffer
+{
+	DotBuffer(const DotBuffer&);
+	DotBuffer& operator = (const DotBuffer&);
+
+	const char* data;
+	size_t length;
+	bool mapped;
+	std::vector<char> storage;
+
+	DotBuffer(): data(NULL), length(0), mapped(false) {}
+
+public:
+	~DotBuffer();
+
+	// reads stdin if the filename is empty; throws 1 if the file cannot be opened
+	static std::shared_ptr<DotBuffer> Load(const std::string& filename);
+	// takes the contents of the text away, leaving it empty
+	static std::shared_ptr<DotBuffer> Take(std::vector<char>& text);
+
+	const char* begin() const
+	{
+		return data;
+	}
+
+	const char* end() const
+	{
+		return data + length;
+	}
+};
+
+// Receives the entries of a graph in the order of the input
+class DotHandler
+{
+public:
+	virtual ~DotHandler() {}
+
+	// default attributes of nodes, edges or the graph; id is 'node', 'edge' or 'graph'
+	virtual void style(const StrRef& id, Attributes& attr) = 0;
+	virtual void node(const StrRef& id, Attributes& attr) = 0;
+	virtual void edge(const StrRef& s, const StrRef& t, Attributes& attr) = 0;
+};
+
+// Streaming parser of flat DOT graphs (subgraphs are not supported)
+//
+// Statements are separated by semicolons. Ids and attribute values are passed to the handler
+// as views of the input text, with the surrounding quotes removed; the handler may take
+// the attributes away by swapping them
+class DotParser
+{
+	DotParser(const DotParser&);
+	DotParser& operator = (const DotParser&);
+
+	DotHandler& handler;
+	Attributes attr;
+
+public:
+	DotParser(DotHandler& handler): handler(handler) {}
+
+	void Parse(const DotBuffer& buffer)
+	{
+		Parse(buffer.begin(), buffer.end());
+	}
+
+	void Parse(const char* begin, const char* end);
+
+private:
+	void ParseStatement(const StrRef& line);
+	void ParseAttr(const StrRef& line);
+};
+
+}
@@ -0,0 +1,86 @@
+#include "dotio/dot_writer.h"
+
+#include <iostream>
+
+namespace dotio {
+
+DotStreamWriter::DotStreamWriter(const std::string& filename): file(stdout), ownsFile(false), text(NULL), buffer(1 << 20), used(0)
+{
+	if (filename != "")
+	{
+		file = fopen(filename.c_str(), "wb");
+		if (file == NULL)
+		{
+			std::cerr << "can't open output file '" << filename << "'" << std::endl;
+			throw 1;
+		}
+		ownsFile = true;
+	}
+}
+
+DotStreamWriter::DotStreamWriter(std::string* text): file(NULL), ownsFile(false), text(text), buffer(1 << 16), used(0)
+{
+}
+
+DotStreamWriter::~DotStreamWriter()
+{
+	Flush();
+	if (ownsFile)
+		fclose(file);
+}
+
+void DotStreamWriter::Flush()
+{
+	if (used > 0)
+		output(&buffer[0], used);
+	used = 0;
+	if (file != NULL)
+		fflush(file);
+}
+
+void DotStreamWriter::WriteStyle(const StrRef& id, const Attributes& attr, bool emptyBrackets)
+{
+	put(StrRef("  ", 2));
+	put(id);
+	put(' ');
+	if (attr.size() > 0 || emptyBrackets)
+		WriteAttr(attr);
+	put(StrRef(";\n", 2));
+}
+
+void DotStreamWriter::WriteNode(const StrRef& id, const Attributes& attr)
+{
+	put(StrRef("  ", 2));
+	putQuoted(id);
+	put(' ');
+	if (attr.size() > 0)
+		WriteAttr(attr);
+	put(StrRef(";\n", 2));
+}
+
+void DotStreamWriter::WriteEdge(const StrRef& s, const StrRef& t, const Attributes& attr)
+{
+	put(StrRef("  ", 2));
+	putQuoted(s);
+	put(StrRef(" -- ", 4));
+	putQuoted(t);
+	put(' ');
+	if (attr.size() > 0)
+		WriteAttr(attr);
+	put(StrRef(";\n", 2));
+}
+
+void DotStreamWriter::WriteAttr(const Attributes& attr)
+{
+	put('[');
+	for (int i = 0; i < attr.size(); i++)
+	{
+		if (i > 0) put(StrRef(", ", 2));
+		put(attr.name(i));
+		put('=');
+		putQuoted(attr.value(i));
+	}
+	put(']');
+}
+
+}
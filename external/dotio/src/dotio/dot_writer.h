@@ -0,0 +1,97 @@
+#pragma once
+
+#include "dotio/attributes.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace dotio {
+
+// Buffered DOT output; entries are written directly into the buffer
+//
+// Attributes are written in the alphabetical order of the keys, as key="value"
+class DotStreamWriter
+{
+	DotStreamWriter(const DotStreamWriter&);
+	DotStreamWriter& operator = (const DotStreamWriter&);
+
+	FILE* file;
+	bool ownsFile;
+	std::string* text;
+	std::vector<char> buffer;
+	size_t used;
+
+public:
+	// writes to stdout if the filename is empty; throws 1 if the file cannot be created
+	explicit DotStreamWriter(const std::string& filename);
+	// appends to the text
+	explicit DotStreamWriter(std::string* text);
+	~DotStreamWriter();
+
+	void BeginGraph()
+	{
+		put(StrRef("graph {\n", 8));
+	}
+
+	void EndGraph()
+	{
+		put(StrRef("}\n", 2));
+		Flush();
+	}
+
+	// unquoted id; empty attributes are written as "[]" only if emptyBrackets is set
+	void WriteStyle(const StrRef& id, const Attributes& attr, bool emptyBrackets);
+	void WriteNode(const StrRef& id, const Attributes& attr);
+	void WriteEdge(const StrRef& s, const StrRef& t, const Attributes& attr);
+
+	// raw text, e.g. a report that is not a graph
+	void Write(const StrRef& s)
+	{
+		put(s);
+	}
+
+	void Flush();
+
+private:
+	void WriteAttr(const Attributes& attr);
+
+	void put(char c)
+	{
+		if (used == buffer.size()) Flush();
+		buffer[used++] = c;
+	}
+
+	void put(const StrRef& s)
+	{
+		if (used + s.length > buffer.size())
+		{
+			Flush();
+			if ((size_t)s.length > buffer.size())
+			{
+				output(s.data, s.length);
+				return;
+			}
+		}
+
+		memcpy(&buffer[used], s.data, s.length);
+		used += s.length;
+	}
+
+	void output(const char* data, size_t length)
+	{
+		if (text != NULL)
+			text->append(data, length);
+		else
+			fwrite(data, 1, length, file);
+	}
+
+	void putQuoted(const StrRef& s)
+	{
+		put('"');
+		put(s);
+		put('"');
+	}
+};
+
+}
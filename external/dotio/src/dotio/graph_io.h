@@ -0,0 +1,145 @@
+#pragma once
+
+#include "dotio/dot_reader.h"
+#include "dotio/dot_writer.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace dotio {
+
+// Reads a DOT file into the graph of a tool
+//
+// The graph has the vectors style, nodes and edges (of Node* and Edge*), the buffer of the input
+// and initAdjacencyList(); nodes and edges are created by Node(index) and Edge(index), and
+// have an id or the ids s and t of the endpoints, and attributes attr
+template<class Graph, class Node, class Edge>
+class GraphReader
+{
+	GraphReader(const GraphReader&);
+	GraphReader& operator = (const GraphReader&);
+
+	//collects parsed entries into a graph
+	class GraphBuilder: public DotHandler
+	{
+		Graph& g;
+		bool dropDuplicateEdges;
+
+	public:
+		GraphBuilder(Graph& g, bool dropDuplicateEdges): g(g), dropDuplicateEdges(dropDuplicateEdges) {}
+
+		void style(const StrRef& id, Attributes& attr)
+		{
+			Node* v = new Node(-1);
+			v->id = id.str();
+			v->attr.swap(attr);
+			g.style.push_back(v);
+		}
+
+		void node(const StrRef& id, Attributes& attr)
+		{
+			Node* v = new Node(g.nodes.size());
+			v->id = id.str();
+			v->attr.swap(attr);
+			g.nodes.push_back(v);
+		}
+
+		void edge(const StrRef& s, const StrRef& t, Attributes& attr)
+		{
+			if (dropDuplicateEdges && !g.edges.empty() && StrRef(g.edges.back()->s) == s && StrRef(g.edges.back()->t) == t)
+				return;
+
+			Edge* e = new Edge(g.edges.size());
+			e->s = s.str();
+			e->t = t.str();
+			e->attr.swap(attr);
+			g.edges.push_back(e);
+		}
+	};
+
+	bool dropDuplicateEdges;
+
+public:
+	// consecutive duplicate edges are dropped, if requested (as mapsets does)
+	explicit GraphReader(bool dropDuplicateEdges = false): dropDuplicateEdges(dropDuplicateEdges) {}
+
+	Graph ReadGraph(const std::string& filename)
+	{
+		return ReadGraph(DotBuffer::Load(filename));
+	}
+
+	Graph ReadGraph(const std::shared_ptr<DotBuffer>& buffer)
+	{
+		Graph g;
+		g.buffer = buffer;
+
+		GraphBuilder builder(g, dropDuplicateEdges);
+		DotParser(builder).Parse(*g.buffer);
+
+		//the nodes of the edges have to be listed
+		for (int i = 0; i < (int)g.edges.size(); i++)
+		{
+			Edge* e = g.edges[i];
+			if (g.findNodeById(e->s) == NULL || g.findNodeById(e->t) == NULL)
+			{
+				std::cerr << "unknown node of the edge '" << e->s << "' -- '" << e->t << "'\n";
+				Free(g);
+				throw 1;
+			}
+		}
+
+		g.initAdjacencyList();
+		return g;
+	}
+
+private:
+	static void Free(Graph& g)
+	{
+		for (int i = 0; i < (int)g.style.size(); i++)
+			delete g.style[i];
+		for (int i = 0; i < (int)g.nodes.size(); i++)
+			delete g.nodes[i];
+		for (int i = 0; i < (int)g.edges.size(); i++)
+			delete g.edges[i];
+	}
+};
+
+// Writes the graph of a tool (see GraphReader) in the order of its entries
+template<class Graph>
+class GraphWriter
+{
+	GraphWriter(const GraphWriter&);
+	GraphWriter& operator = (const GraphWriter&);
+
+	bool emptyBrackets;
+
+public:
+	// empty attributes of the styles are written as "[]" only if emptyBrackets is set
+	// (pointcloud omits them)
+	explicit GraphWriter(bool emptyBrackets = true): emptyBrackets(emptyBrackets) {}
+
+	void WriteGraph(const std::string& filename, const Graph& g)
+	{
+		DotStreamWriter writer(filename);
+		WriteGraph(writer, g);
+	}
+
+	void WriteGraph(DotStreamWriter& writer, const Graph& g)
+	{
+		writer.BeginGraph();
+
+		for (int i = 0; i < (int)g.style.size(); i++)
+			writer.WriteStyle(g.style[i]->id, g.style[i]->attr, emptyBrackets);
+
+		for (int i = 0; i < (int)g.nodes.size(); i++)
+			writer.WriteNode(g.nodes[i]->id, g.nodes[i]->attr);
+
+		for (int i = 0; i < (int)g.edges.size(); i++)
+			writer.WriteEdge(g.edges[i]->s, g.edges[i]->t, g.edges[i]->attr);
+
+		writer.EndGraph();
+	}
+};
+
+}
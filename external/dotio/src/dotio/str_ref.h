@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+
+namespace dotio {
+
+// Non-owning view of a piece of text
+struct StrRef
+{
+	const char* data;
+	int length;
+
+	StrRef(): data(""), length(0) {}
+	StrRef(const char* data, int length): data(data), length(length) {}
+	StrRef(const char* begin, const char* end): data(begin), length((int)(end - begin)) {}
+	StrRef(const std::string& s): data(s.data()), length((int)s.length()) {}
+
+	bool empty() const
+	{
+		return length == 0;
+	}
+
+	const char* begin() const
+	{
+		return data;
+	}
+
+	const char* end() const
+	{
+		return data + length;
+	}
+
+	std::string str() const
+	{
+		return std::string(data, length);
+	}
+
+	bool operator == (const StrRef& o) const
+	{
+		return length == o.length && memcmp(data, o.data, length) == 0;
+	}
+
+	bool operator != (const StrRef& o) const
+	{
+		return !(*this == o);
+	}
+
+	// the order of std::string
+	bool operator < (const StrRef& o) const
+	{
+		int c = memcmp(data, o.data, (length < o.length ? length : o.length));
+		if (c != 0) return c < 0;
+		return length < o.length;
+	}
+};
+
+// FNV-1a hash of the text, for the hash tables over views
+struct StrRefHash
+{
+	size_t operator()(const StrRef& s) const
+	{
+		size_t h = 2166136261u;
+		for (int i = 0; i < s.length; i++)
+			h = (h ^ (unsigned char)s.data[i]) * 16777619u;
+		return h;
+	}
+};
+
+}
@@ -0,0 +1,159 @@
+#include "common/geometry/delaunay_mesh.h"
+#include "common/geometry/delaunay_triangulation.h"
+
+#include "incremental/delaunay_triangulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace geometry;
+
+// Times the construction of DelaunayMesh and the batched point location against the former
+// incremental triangulation (with its grid index) on the same points, and checks that both give
+// the same segments: for uniformly random points and for points on a grid, where many of them
+// are cocircular and the two may choose different diagonals (counted as flips); exits with 1,
+// if the segments differ otherwise; usage: delaunay_bench [n ...] (10^4, 10^5 and 10^6 points by default)
+
+double Seconds(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+vector<Point> RandomPoints(int n, mt19937& rnd)
+{
+	uniform_real_distribution<double> coord(0.0, 1000.0);
+	vector<Point> points(n);
+	for (int i = 0; i < n; i++)
+		points[i] = Point(coord(rnd), coord(rnd));
+	return points;
+}
+
+// n distinct random points of a square grid with about 2n nodes
+vector<Point> GridPoints(int n, mt19937& rnd)
+{
+	int side = (int)sqrt(2.0 * n) + 1;
+	VI cells(side * side);
+	for (int i = 0; i < (int)cells.size(); i++)
+		cells[i] = i;
+	shuffle(cells.begin(), cells.end(), rnd);
+
+	vector<Point> points(n);
+	for (int i = 0; i < n; i++)
+		points[i] = Point(cells[i] % side, cells[i] / side);
+	return points;
+}
+
+// the segments with their endpoints in order, since the two triangulations may orient them differently
+set<Segment> Undirected(const set<Segment>& segments)
+{
+	set<Segment> result;
+	for (auto& s : segments)
+		result.insert(s.first < s.second ? s : Segment(s.second, s.first));
+	return result;
+}
+
+bool Cocircular(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+	double ax = a.x - d.x, ay = a.y - d.y, bx = b.x - d.x, by = b.y - d.y, cx = c.x - d.x, cy = c.y - d.y;
+	double det = (ax * ax + ay * ay) * (bx * cy - cx * by) - (bx * bx + by * by) * (ax * cy - cx * ay) + (cx * cx + cy * cy) * (ax * by - bx * ay);
+	return det == 0;
+}
+
+double Cross(const Point& a, const Point& b, const Point& c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// checks that every segment of the first triangulation missing in the second one is optional: its
+// triangles on both sides have a common circumcircle, so that flipping it keeps the triangulation
+// Delaunay (exact for integer coordinates)
+bool FlippedDiagonals(const set<Segment>& first, const set<Segment>& second, int& flipped)
+{
+	map<Point, set<Point> > adjacent;
+	for (auto& s : first)
+	{
+		adjacent[s.first].insert(s.second);
+		adjacent[s.second].insert(s.first);
+	}
+
+	flipped = 0;
+	for (auto& s : first)
+	{
+		if (second.count(s)) continue;
+
+		vector<Point> left, right;
+		for (auto& c : adjacent[s.first])
+			if (adjacent[s.second].count(c))
+				(Cross(s.first, s.second, c) > 0 ? left : right).push_back(c);
+
+		bool found = false;
+		for (int i = 0; i < (int)left.size() && !found; i++)
+			for (int j = 0; j < (int)right.size() && !found; j++)
+				found = Cocircular(s.first, s.second, left[i], right[j]);
+
+		if (!found) return false;
+		flipped++;
+	}
+
+	return true;
+}
+
+// returns false if the segments differ other than in the diagonals of cocircular points
+bool Run(const char* kind, int n, const vector<Point>& points, const vector<Point>& queries)
+{
+	auto start = chrono::steady_clock::now();
+	DelaunayMesh mesh(points);
+	double build = Seconds(start);
+
+	start = chrono::steady_clock::now();
+	VI faces;
+	mesh.locate(queries, faces);
+	double locate = Seconds(start);
+
+	start = chrono::steady_clock::now();
+	auto old = incremental::DelaunayTriangulation::Create(points);
+	old->InitializeIndex();
+	double oldBuild = Seconds(start);
+
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < (int)queries.size(); i++)
+		old->find(queries[i]);
+	double oldLocate = Seconds(start);
+
+	set<Segment> segments = Undirected(DelaunayTriangulation::Create(points)->getSegments());
+	set<Segment> oldSegments = Undirected(old->getSegments());
+	int flipped = 0, oldFlipped = 0;
+	bool same = (segments.size() == oldSegments.size() && FlippedDiagonals(segments, oldSegments, flipped) && FlippedDiagonals(oldSegments, segments, oldFlipped));
+
+	string result = (!same ? "DIFFER" : flipped == 0 ? "same" : "flip " + to_string(flipped));
+	printf("%8s %10d %10d %10.3f %10.3f %10.3f %10.3f %10s\n", kind, n, (int)segments.size(), build, locate, oldBuild, oldLocate, result.c_str());
+	fflush(stdout);
+	return same;
+}
+
+int main(int argc, char** argv)
+{
+	VI sizes;
+	for (int i = 1; i < argc; i++)
+		sizes.push_back(atoi(argv[i]));
+	if (sizes.empty())
+		sizes = {10000, 100000, 1000000};
+
+	printf("%8s %10s %10s %10s %10s %10s %10s %10s\n", "input", "points", "segments", "build(s)", "locate(s)", "old build", "old locate", "segments");
+	bool same = true;
+	for (int n : sizes)
+	{
+		mt19937 rnd(n);
+		vector<Point> queries = RandomPoints(n, rnd);
+
+		same &= Run("random", n, RandomPoints(n, rnd), queries);
+		same &= Run("grid", n, GridPoints(n, rnd), queries);
+	}
+
+	return (same ? 0 : 1);
+}
@@ -1,6 +1,7 @@
 #include "grid_index.h"
 
 namespace geometry {
+namespace incremental {
 
 /**
     * Constructs a grid index holding the triangles of a delaunay triangulation.
@@ -157,4 +158,5 @@ Point GridIndex::middleOfCell(int x_index, int y_index) const
     return Point(middleXCell, middleYCell);
 }
 
+} // namespace incremental
 } // namespace geometry
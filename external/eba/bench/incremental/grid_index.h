@@ -3,6 +3,7 @@
 #include "delaunay_triangulation.h"
 
 namespace geometry {
+namespace incremental {
 
 struct Cell
 {
@@ -104,4 +105,5 @@ private:
     Point middleOfCell(int x_index, int y_index) const;
 };
 
+} // namespace incremental
 } // namespace geometry
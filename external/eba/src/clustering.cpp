@@ -224,3 +224,40 @@ void ClusterAlgorithm::cluster(DotGraph& g)
 	//cerr<<"guessed number of clusters: "<<K<<"\n";
 	cluster(g, K);
 }
+
+void ClusterGraph(DotGraph& g, const string& algoName, const string& numberOfClusters, bool parallelModularity)
+{
+	ClusterAlgorithm* algo = NULL;
+
+	if (algoName == "geometrickmeans")
+		algo = new GeometricKMeans();
+	else if (algoName == "graphkmeans")
+		algo = new GraphKMeans();
+	else if (algoName == "geometrichierarchical")
+		algo = new GeometricHierarchical();
+	else if (algoName == "graphhierarchical")
+		algo = new GraphHierarchical();
+	else if (algoName == "infomap")
+		algo = new InfoMap();
+	else if (algoName == "modularity")
+		algo = new Modularity(false, parallelModularity);
+	else if (algoName == "modularity-cont")
+		algo = new Modularity(true, parallelModularity);
+
+	if (numberOfClusters == "graph")
+	{
+		int k = g.ClusterCount();
+		algo->cluster(g, k);
+	}
+	else if (numberOfClusters == "")
+	{
+		algo->cluster(g);
+	}
+	else
+	{
+		int k = toInt(numberOfClusters);
+		algo->cluster(g, k);
+	}
+
+	delete algo;
+}
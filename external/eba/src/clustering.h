@@ -113,8 +113,9 @@ class InfoMap: public ClusterAlgorithm
 class Modularity: public ClusterAlgorithm
 {
 	bool contigous;
+	bool parallel;
 public:
-	Modularity(bool contigous): contigous(contigous) {}
+	Modularity(bool contigous, bool parallel): contigous(contigous), parallel(parallel) {}
 
 	void cluster(DotGraph& g);
 	void cluster(DotGraph& g, int K);
@@ -123,3 +124,8 @@ public:
 		return VVN();
 	}
 };
+
+//clusters the graph by the algorithm with the given name (a value of -C);
+//numberOfClusters is either a number, "graph" (as many as in the input), or "" (selected automatically);
+//parallelModularity selects the parallel local moving of modularity and modularity-cont
+void ClusterGraph(DotGraph& g, const string& algoName, const string& numberOfClusters, bool parallelModularity = false);
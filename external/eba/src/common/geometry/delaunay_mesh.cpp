@@ -0,0 +1,491 @@
+#include "delaunay_mesh.h"
+
+#include "profile/profile.h"
+
+#include <algorithm>
+#include <random>
+#include <cassert>
+
+namespace geometry {
+
+namespace {
+
+// the faces visited by the walks locating points; the walks falling back to the scan of all faces
+profile::Counter WalkSteps("delaunay_walk_steps");
+profile::Counter SlowLocations("delaunay_slow_locations");
+
+// positive iff p is to the left of ab
+double Orient(const Point& a, const Point& b, const Point& p)
+{
+	return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+// positive iff p is inside the circumcircle of the counterclockwise triangle abc
+double InCircle(const Point& a, const Point& b, const Point& c, const Point& p)
+{
+	long double adx = a.x - p.x, ady = a.y - p.y;
+	long double bdx = b.x - p.x, bdy = b.y - p.y;
+	long double cdx = c.x - p.x, cdy = c.y - p.y;
+
+	long double alift = adx * adx + ady * ady;
+	long double blift = bdx * bdx + bdy * bdy;
+	long double clift = cdx * cdx + cdy * cdy;
+
+	return (double)(adx * (bdy * clift - cdy * blift) - ady * (bdx * clift - cdx * blift) + alift * (bdx * cdy - cdx * bdy));
+}
+
+// the keys of the points along a Hilbert curve over a 2^16 x 2^16 grid covering them
+vector<unsigned long long> HilbertKeys(const vector<Point>& points)
+{
+	vector<unsigned long long> keys(points.size(), 0);
+	if (points.empty()) return keys;
+
+	double xl = points[0].x, xr = points[0].x, yl = points[0].y, yr = points[0].y;
+	for (int i = 1; i < (int)points.size(); i++)
+	{
+		xl = min(xl, points[i].x);
+		xr = max(xr, points[i].x);
+		yl = min(yl, points[i].y);
+		yr = max(yr, points[i].y);
+	}
+
+	const unsigned n = 1u << 16;
+	double size = max(xr - xl, yr - yl);
+	double scale = (size > 0 ? (n - 1) / size : 0);
+	for (int i = 0; i < (int)points.size(); i++)
+	{
+		unsigned x = min(n - 1, (unsigned)((points[i].x - xl) * scale));
+		unsigned y = min(n - 1, (unsigned)((points[i].y - yl) * scale));
+
+		unsigned long long d = 0;
+		for (unsigned s = n / 2; s > 0; s /= 2)
+		{
+			unsigned rx = ((x & s) > 0);
+			unsigned ry = ((y & s) > 0);
+			d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+
+			// rotate the quadrant
+			if (ry == 0)
+			{
+				if (rx == 1)
+				{
+					x = n - 1 - x;
+					y = n - 1 - y;
+				}
+				swap(x, y);
+			}
+		}
+
+		keys[i] = d;
+	}
+
+	return keys;
+}
+
+// the order of the points along a Hilbert curve
+VI HilbertOrder(const vector<Point>& points)
+{
+	vector<unsigned long long> keys = HilbertKeys(points);
+
+	VI order(points.size());
+	for (int i = 0; i < (int)order.size(); i++)
+		order[i] = i;
+
+	sort(order.begin(), order.end(), [&](int a, int b) { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+	return order;
+}
+
+// biased randomized insertion order: a point is in the last round with probability 1/2, in
+// the one before it with probability 1/4 and so on; every round is sorted along a Hilbert curve
+VI BrioOrder(const vector<Point>& points)
+{
+	int n = (int)points.size();
+	int rounds = 1;
+	while ((1 << rounds) < n) rounds++;
+
+	// a fixed seed, so that the global random generator is not affected
+	mt19937 rng(12345);
+	VI round(n);
+	for (int i = 0; i < n; i++)
+	{
+		int r = rounds - 1;
+		while (r > 0 && (rng() & 1)) r--;
+		round[i] = r;
+	}
+
+	vector<unsigned long long> keys = HilbertKeys(points);
+
+	VI order(n);
+	for (int i = 0; i < n; i++)
+		order[i] = i;
+
+	sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		if (round[a] != round[b]) return round[a] < round[b];
+		if (keys[a] != keys[b]) return keys[a] < keys[b];
+		return a < b;
+	});
+	return order;
+}
+
+} // namespace
+
+DelaunayMesh::DelaunayMesh(const vector<Point>& input): lastFace(-1), stamp(0)
+{
+	points.reserve(input.size());
+	faces.reserve(2 * input.size() + 4);
+	deleted.reserve(2 * input.size() + 4);
+
+	VI order = BrioOrder(input);
+	for (int i = 0; i < (int)order.size(); i++)
+		insert(input[order[i]]);
+}
+
+int DelaunayMesh::insert(const Point& p)
+{
+	if (lastFace == -1)
+		return insertCollinear(p);
+
+	// a vertex at the same position is a corner of the face containing the point
+	int f = locate(p, lastFace);
+	for (int i = 0; i < 3; i++)
+	{
+		int v = faces[f].v[i];
+		if (v != Infinite && points[v] == p) return v;
+	}
+
+	int v = (int)points.size();
+	points.push_back(p);
+	insertVertex(v, f);
+	return v;
+}
+
+int DelaunayMesh::insertCollinear(const Point& p)
+{
+	for (int i = 0; i < (int)points.size(); i++)
+		if (points[i] == p) return i;
+
+	int v = (int)points.size();
+	points.push_back(p);
+	if (v < 2 || Orient(points[0], points[1], p) == 0) return v;
+
+	// the first point off the line
+	startTriangulation(0, 1, v);
+	for (int i = 2; i < v; i++)
+		insertVertex(i, locate(points[i], lastFace));
+
+	return v;
+}
+
+void DelaunayMesh::startTriangulation(int a, int b, int c)
+{
+	if (Orient(points[a], points[b], points[c]) < 0) swap(b, c);
+
+	int t = newFace(a, b, c);
+	// the ghost faces across the sides of the triangle
+	int ga = newFace(c, b, Infinite);
+	int gb = newFace(a, c, Infinite);
+	int gc = newFace(b, a, Infinite);
+
+	link(t, 0, ga); link(ga, 2, t);
+	link(t, 1, gb); link(gb, 2, t);
+	link(t, 2, gc); link(gc, 2, t);
+
+	link(ga, 0, gc); link(gc, 1, ga);
+	link(gc, 0, gb); link(gb, 1, gc);
+	link(gb, 0, ga); link(ga, 1, gb);
+
+	lastFace = t;
+}
+
+bool DelaunayMesh::inConflict(int f, const Point& p) const
+{
+	const Face& face = faces[f];
+
+	int inf = -1;
+	for (int i = 0; i < 3; i++)
+		if (face.v[i] == Infinite) inf = i;
+
+	if (inf == -1)
+		return InCircle(points[face.v[0]], points[face.v[1]], points[face.v[2]], p) > 0;
+
+	// a ghost face conflicts with the points outside of its side of the hull
+	const Point& a = points[face.v[(inf + 1) % 3]];
+	const Point& b = points[face.v[(inf + 2) % 3]];
+	double o = Orient(a, b, p);
+	if (o != 0) return o > 0;
+
+	// on the line of the side: conflicts if the point is inside the side
+	return (p.x - a.x) * (b.x - a.x) + (p.y - a.y) * (b.y - a.y) > 0 && (p.x - b.x) * (a.x - b.x) + (p.y - b.y) * (a.y - b.y) > 0;
+}
+
+void DelaunayMesh::insertVertex(int v, int start)
+{
+	const Point& p = points[v];
+
+	visited.resize(faces.size(), 0);
+	conflicting.resize(faces.size(), 0);
+	stamp++;
+
+	// the faces in conflict with the point form a cavity around the start
+	VI cavity(1, start);
+	visited[start] = conflicting[start] = stamp;
+	for (int k = 0; k < (int)cavity.size(); k++)
+	{
+		const Face& face = faces[cavity[k]];
+		for (int i = 0; i < 3; i++)
+		{
+			int g = face.n[i];
+			if (visited[g] == stamp) continue;
+
+			visited[g] = stamp;
+			if (inConflict(g, p))
+			{
+				conflicting[g] = stamp;
+				cavity.push_back(g);
+			}
+		}
+	}
+
+	// the sides of the cavity (counterclockwise around the point) with the faces outside;
+	// the point has to see every side from the inside, otherwise (due to rounding errors)
+	// the face of the side is left out of the cavity
+	struct Side
+	{
+		int a, b, outer, outerSide;
+	};
+
+	vector<Side> sides;
+	bool valid = false;
+	while (!valid)
+	{
+		valid = true;
+		sides.clear();
+		for (int k = 0; k < (int)cavity.size() && valid; k++)
+		{
+			int f = cavity[k];
+			if (conflicting[f] != stamp) continue;
+
+			const Face& face = faces[f];
+			for (int i = 0; i < 3; i++)
+			{
+				int g = face.n[i];
+				if (conflicting[g] == stamp) continue;
+
+				Side side;
+				side.a = face.v[(i + 1) % 3];
+				side.b = face.v[(i + 2) % 3];
+				side.outer = g;
+				side.outerSide = sideOf(g, f);
+
+				if (f != start && side.a != Infinite && side.b != Infinite && Orient(points[side.a], points[side.b], p) <= 0)
+				{
+					conflicting[f] = 0;
+					valid = false;
+					break;
+				}
+
+				sides.push_back(side);
+			}
+		}
+	}
+
+	for (int k = 0; k < (int)cavity.size(); k++)
+		if (conflicting[cavity[k]] == stamp) deleteFace(cavity[k]);
+
+	// the faces connecting the sides with the point
+	faceFrom.resize(points.size() + 1, -1);
+	VI created;
+	for (int k = 0; k < (int)sides.size(); k++)
+	{
+		const Side& side = sides[k];
+		int f = newFace(side.a, side.b, v);
+		link(f, 2, side.outer);
+		link(side.outer, side.outerSide, f);
+
+		faceFrom[side.a + 1] = f;
+		created.push_back(f);
+	}
+
+	for (int k = 0; k < (int)created.size(); k++)
+	{
+		int f = created[k];
+		int g = faceFrom[faces[f].v[1] + 1];
+		assert(g != -1);
+		link(f, 0, g);
+		link(g, 1, f);
+
+		if (!isGhost(f)) lastFace = f;
+	}
+
+	for (int k = 0; k < (int)sides.size(); k++)
+		faceFrom[sides[k].a + 1] = -1;
+}
+
+int DelaunayMesh::locate(const Point& p, int start) const
+{
+	if (lastFace == -1) return -1;
+
+	int f = (start >= 0 && start < (int)faces.size() && !deleted[start] ? start : lastFace);
+	if (isGhost(f))
+	{
+		// the face across the side of the hull
+		for (int i = 0; i < 3; i++)
+			if (faces[f].v[i] == Infinite) f = faces[f].n[i];
+	}
+
+	// visibility walk; the first side to test is rotated to avoid cycles
+	int rotation = 0;
+	for (int steps = 0; steps <= (int)faces.size(); steps++)
+	{
+		const Face& face = faces[f];
+
+		int next = -1;
+		for (int k = 0; k < 3 && next == -1; k++)
+		{
+			int i = (rotation + k) % 3;
+			if (Orient(points[face.v[(i + 1) % 3]], points[face.v[(i + 2) % 3]], p) < 0)
+				next = face.n[i];
+		}
+
+		if (next == -1)
+		{
+			WalkSteps.add(steps + 1);
+			return f;
+		}
+
+		f = next;
+		rotation = (rotation + 1) % 3;
+		if (isGhost(f))
+		{
+			WalkSteps.add(steps + 2);
+			return f;
+		}
+	}
+
+	// the walk is cycling (due to rounding errors)
+	WalkSteps.add(faces.size() + 1);
+	SlowLocations.add();
+	return locateSlowly(p);
+}
+
+int DelaunayMesh::locateSlowly(const Point& p) const
+{
+	int outside = -1;
+	for (int f = 0; f < (int)faces.size(); f++)
+	{
+		if (deleted[f] || isGhost(f)) continue;
+
+		const Face& face = faces[f];
+		bool inside = true;
+		for (int i = 0; i < 3; i++)
+		{
+			if (Orient(points[face.v[(i + 1) % 3]], points[face.v[(i + 2) % 3]], p) < 0)
+			{
+				inside = false;
+				if (isGhost(face.n[i])) outside = face.n[i];
+			}
+		}
+
+		if (inside) return f;
+	}
+
+	assert(outside != -1);
+	return outside;
+}
+
+void DelaunayMesh::locate(const vector<Point>& queries, VI& result) const
+{
+	result.assign(queries.size(), -1);
+
+	VI order = HilbertOrder(queries);
+	int f = lastFace;
+	for (int k = 0; k < (int)order.size(); k++)
+	{
+		f = locate(queries[order[k]], f);
+		result[order[k]] = f;
+	}
+}
+
+vector<pair<int, int> > DelaunayMesh::edges() const
+{
+	vector<pair<int, int> > res;
+	if (lastFace == -1)
+	{
+		// collinear points: consecutive along the line
+		int n = (int)points.size();
+		if (n < 2) return res;
+
+		Point dir = points[1] - points[0];
+		VI order(n);
+		for (int i = 0; i < n; i++)
+			order[i] = i;
+		sort(order.begin(), order.end(), [&](int a, int b) { return dir.x * points[a].x + dir.y * points[a].y < dir.x * points[b].x + dir.y * points[b].y; });
+
+		for (int i = 0; i + 1 < n; i++)
+			res.push_back(make_pair(order[i], order[i + 1]));
+		return res;
+	}
+
+	for (int f = 0; f < (int)faces.size(); f++)
+	{
+		if (deleted[f] || isGhost(f)) continue;
+
+		const Face& face = faces[f];
+		for (int i = 0; i < 3; i++)
+		{
+			int a = face.v[(i + 1) % 3];
+			int b = face.v[(i + 2) % 3];
+			if (a < b || isGhost(face.n[i]))
+				res.push_back(make_pair(a, b));
+		}
+	}
+
+	return res;
+}
+
+int DelaunayMesh::newFace(int a, int b, int c)
+{
+	int f;
+	if (!freeFaces.empty())
+	{
+		f = freeFaces.back();
+		freeFaces.pop_back();
+	}
+	else
+	{
+		f = (int)faces.size();
+		faces.push_back(Face());
+		deleted.push_back(0);
+	}
+
+	Face& face = faces[f];
+	face.v[0] = a;
+	face.v[1] = b;
+	face.v[2] = c;
+	face.n[0] = face.n[1] = face.n[2] = -1;
+	deleted[f] = 0;
+	return f;
+}
+
+void DelaunayMesh::deleteFace(int f)
+{
+	deleted[f] = 1;
+	freeFaces.push_back(f);
+}
+
+void DelaunayMesh::link(int f, int i, int g)
+{
+	faces[f].n[i] = g;
+}
+
+int DelaunayMesh::sideOf(int f, int neighbor) const
+{
+	for (int i = 0; i < 3; i++)
+		if (faces[f].n[i] == neighbor) return i;
+
+	assert(false);
+	return -1;
+}
+
+} // namespace geometry
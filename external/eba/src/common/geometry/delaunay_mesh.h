@@ -0,0 +1,118 @@
+#pragma once
+
+#include "common/common.h"
+#include "common/geometry/point.h"
+
+namespace geometry {
+
+/**
+ * Delaunay triangulation stored in flat arrays
+ *
+ * The triangles (faces) are kept in one array, and the slots of the deleted ones are reused.
+ * A face holds the indices of its vertices in counterclockwise order and the indices of the
+ * neighbors across the opposite sides. The outside of the convex hull is covered by ghost
+ * faces, which have the vertex Infinite, so that every face has three neighbors.
+ *
+ * The points given to the constructor are inserted in a biased randomized order (BRIO) with
+ * every round sorted along a Hilbert curve; consecutive points are close to each other, so
+ * the walks locating them are short. A point is inserted by removing the faces whose
+ * circumcircles contain it (Bowyer-Watson). Duplicated points are ignored.
+ */
+class DelaunayMesh
+{
+public:
+	static const int Infinite = -1;
+
+	struct Face
+	{
+		int v[3];
+		// n[i] is the neighbor across the side opposite to v[i]
+		int n[3];
+	};
+
+private:
+	vector<Point> points;
+	vector<Face> faces;
+	// faces[i] is deleted and can be reused
+	vector<char> deleted;
+	VI freeFaces;
+	// the face created last (a walk starts from it)
+	int lastFace;
+
+	// the marks of the faces visited while an insertion looks for the conflicting ones
+	VI visited, conflicting;
+	int stamp;
+	// the new face with the given first vertex (shifted by one for Infinite)
+	VI faceFrom;
+
+public:
+	DelaunayMesh(): lastFace(-1), stamp(0) {}
+	explicit DelaunayMesh(const vector<Point>& points);
+
+	// inserts the point; returns its index or the index of the vertex at the same position
+	int insert(const Point& p);
+
+	int vertexCount() const
+	{
+		return (int)points.size();
+	}
+
+	const Point& vertex(int index) const
+	{
+		return points[index];
+	}
+
+	// the number of slots of faces (some of them can be deleted)
+	int faceCount() const
+	{
+		return (int)faces.size();
+	}
+
+	bool isDeleted(int f) const
+	{
+		return deleted[f] != 0;
+	}
+
+	bool isGhost(int f) const
+	{
+		const Face& face = faces[f];
+		return (face.v[0] == Infinite || face.v[1] == Infinite || face.v[2] == Infinite);
+	}
+
+	const Face& face(int f) const
+	{
+		return faces[f];
+	}
+
+	// the face containing the point (its boundary included) or, if the point is outside of the
+	// convex hull, a ghost face whose side separates it from the hull; -1 if there are no faces
+	// (all points are collinear)
+	int locate(const Point& p) const
+	{
+		return locate(p, lastFace);
+	}
+
+	int locate(const Point& p, int start) const;
+
+	// result[i] = locate(queries[i]); the queries are visited along a Hilbert curve, so that
+	// every walk starts from the face of the previous query
+	void locate(const vector<Point>& queries, VI& result) const;
+
+	// the sides of the faces (every side once) as pairs of vertices; for collinear points,
+	// the segments between consecutive points
+	vector<pair<int, int> > edges() const;
+
+private:
+	int insertCollinear(const Point& p);
+	void startTriangulation(int a, int b, int c);
+	void insertVertex(int v, int start);
+	bool inConflict(int f, const Point& p) const;
+	int locateSlowly(const Point& p) const;
+
+	int newFace(int a, int b, int c);
+	void deleteFace(int f);
+	void link(int f, int i, int g);
+	int sideOf(int f, int neighbor) const;
+};
+
+} // namespace geometry
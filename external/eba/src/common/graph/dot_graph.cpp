@@ -3,52 +3,50 @@
 #include <algorithm>
 #include <queue>
 #include <functional>
+#include <atomic>
 
-void DotGraph::initShortestPaths(DotNode* s, bool weighted)
+long long DotGraph::NextVersion()
 {
-	const double INF = 123456789.0;
+	static atomic<long long> counter(0);
+	return counter++;
+}
+
+distances::GraphDistances& DotGraph::getDistances(bool weighted)
+{
+	//the graph (or a copy sharing the engines) was changed after the engines were built;
+	//the numbers of nodes and edges also catch direct changes without a call of changed()
+	if (distanceCache->version != version || distanceCache->nodeCount != (int)nodes.size() || distanceCache->edgeCount != (int)edges.size())
+	{
+		if (distanceCache->version != -1)
+			resetDistances(distanceCache->memoryBudget, distanceCache->approximate);
 
-	VD dist(nodes.size(), INF);
-	dist[s->index] = 0;
+		distanceCache->version = version;
+		distanceCache->nodeCount = (int)nodes.size();
+		distanceCache->edgeCount = (int)edges.size();
+	}
 
-	typedef pair<double, int> QE;
+	shared_ptr<distances::GraphDistances>& engine = distanceCache->engine[weighted ? 1 : 0];
+	if (engine) return *engine;
 
-	priority_queue<QE, vector<QE>, greater<QE> > q;
-	q.push(make_pair(0.0, s->index));
+	initAdjacencyList();
 
-	while (!q.empty())
+	distances::CSRGraph csr;
+	csr.offset.push_back(0);
+	for (int v = 0; v < (int)nodes.size(); v++)
 	{
-		QE now = q.top();
-		q.pop();
-
-		if (now.first <= dist[now.second])
+		for (int i = 0; i < (int)adj[v].size(); i++)
 		{
-			int v = now.second;
-			for (int i = 0; i < (int)adj[v].size(); i++)
-			{
-				int next = adj[v][i];
-				DotEdge* edge = edges[adjE[v][i]];
-				assert(edge != NULL);
-
-				double cost = (weighted ? edge->getLen() : 1.0);
-				if (dist[next] > dist[v] + cost)
-				{
-					dist[next] = dist[v] + cost;
-					q.push(make_pair(dist[next], next));
-				}
-			}
+			DotEdge* edge = edges[adjE[v][i]];
+			assert(edge != NULL);
+
+			csr.target.push_back(adj[v][i]);
+			csr.weight.push_back(weighted ? edge->getLen() : 1.0);
 		}
+		csr.offset.push_back((int)csr.target.size());
 	}
 
-	for (int i = 0; i < (int)nodes.size(); i++)
-	{
-		pair<DotNode*, DotNode*> pair = make_pair(s, nodes[i]);
-		double d = (dist[nodes[i]->index] < INF ? dist[nodes[i]->index] : -1);
-		if (weighted)
-			shortestPathsW[pair] = d;
-		else
-			shortestPaths[pair] = (int)d;
-	}
+	engine = shared_ptr<distances::GraphDistances>(new distances::GraphDistances(csr, distanceCache->memoryBudget, distanceCache->approximate));
+	return *engine;
 }
 
 vector<ConnectedDotGraph> DotGraph::getConnectedComponents()
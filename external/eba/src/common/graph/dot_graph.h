@@ -3,10 +3,14 @@
 #include "common/geometry/point.h"
 #include "common/geometry/segment.h"
 #include "common/geometry/rectangle.h"
+#include "dotio/dot_reader.h"
+#include "distances/graph_distances.h"
 
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <iostream>
+#include <memory>
 #include <cassert>
 
 class ConnectedDotGraph;
@@ -20,7 +24,7 @@ private:
 public:
 	int index;
 	string id;
-	map<string, string> attr;
+	dotio::Attributes attr;
 	Point pos;
 
 	DotNode(int index): index(index), pos(-1.0, -1.0) {};
@@ -29,59 +33,66 @@ public:
 	{
 		if (pos.x != -1 || pos.y != -1) return pos;
 
-		if (attr.find("pos") == attr.end())
+		if (!attr.has(dotio::KEY_POS))
 			cerr << "No attribute 'pos' for the node '" << id << "'\n";
 
-		char ch;
-		istringstream (getAttr("pos")) >> pos.x >> ch >> pos.y;
+		assert(attr.has(dotio::KEY_POS));
+		attr.getPoint(dotio::KEY_POS, pos.x, pos.y);
 		return pos;
 	}
 
 	string getCluster()
 	{
-		assert(hasAttr("cluster"));
-		return getAttr("cluster");
+		assert(attr.has(dotio::KEY_CLUSTER));
+		return attr.get(dotio::KEY_CLUSTER).str();
+	}
+
+	string getClusterColor()
+	{
+		if (attr.has(dotio::KEY_CLUSTERCOLOR))
+			return attr.get(dotio::KEY_CLUSTERCOLOR).str();
+		return "";
 	}
 
 	#define SCALE 52.0
 
 	double getWidth()
 	{
-		assert(hasAttr("width"));
-		return getDoubleAttr("width") * SCALE;
+		assert(attr.has(dotio::KEY_WIDTH));
+		return attr.getDouble(dotio::KEY_WIDTH) * SCALE;
 	}
 
 	double getHeight()
 	{
-		assert(hasAttr("height"));
-		return getDoubleAttr("height") * SCALE;
+		assert(attr.has(dotio::KEY_HEIGHT));
+		return attr.getDouble(dotio::KEY_HEIGHT) * SCALE;
 	}
 
 	string getAttr(const string& key)
 	{
-		assert(attr.find(key) != attr.end());
-		return attr[key];
+		assert(attr.has(key));
+		return attr.get(key).str();
 	}
 
 	void setAttr(const string& key, const string& value)
 	{
-		attr[key] = value;
+		attr.set(key, value);
 	}
 
 	bool hasAttr(const string& key)
 	{
-		return (attr.find(key) != attr.end());
+		return attr.has(key);
 	}
 
 	void removeAttr(const string& key)
 	{
-		if (attr.find(key) != attr.end())
-			attr.erase(attr.find(key));
+		attr.remove(key);
 	}
 
 	double getDoubleAttr(const string& key)
 	{
-		return toDouble(getAttr(key));
+		assert(attr.has(key));
+		return attr.getDouble(key);
 	}
 
 	vector<Segment> getBoundary(double marginCoef)
@@ -135,36 +146,42 @@ private:
 public:
 	int index;
 	string s, t;
-	map<string, string> attr;
+	dotio::Attributes attr;
 	double len;
 
 	DotEdge(int index): index(index), len(-1) {}
 
 	double getWeight()
 	{
-		if (attr.find("weight") == attr.end()) return 1.0;
-		return getDoubleAttr("weight");
+		if (!attr.has(dotio::KEY_WEIGHT)) return 1.0;
+		return attr.getDouble(dotio::KEY_WEIGHT);
 	}
 
 	double getLen()
 	{
 		if (len != -1) return len;
 
-		if (attr.find("len") == attr.end()) len = 1;
-		else len = getDoubleAttr("len");
+		if (!attr.has(dotio::KEY_LEN)) len = 1;
+		else len = attr.getDouble(dotio::KEY_LEN);
 
 		return len;
 	}
 
 	string getAttr(const string& key)
 	{
-		if (attr.find(key) == attr.end()) throw 1;
-		return attr[key];
+		if (!attr.has(key)) throw 1;
+		return attr.get(key).str();
 	}
 
 	double getDoubleAttr(const string& key)
 	{
-		return toDouble(getAttr(key));
+		if (!attr.has(key)) throw 1;
+		return attr.getDouble(key);
+	}
+
+	void removeAttr(const string& key)
+	{
+		attr.remove(key);
 	}
 };
 
@@ -174,8 +191,36 @@ class DotGraph
 
 	bool initialized;
 
+	//shortest-path engines (unweighted and weighted) built for the given version of the graph;
+	//shared by the copies of the graph until one of them is changed
+	struct DistanceCache
+	{
+		size_t memoryBudget;
+		bool approximate;
+		long long version;
+		int nodeCount;
+		int edgeCount;
+		shared_ptr<distances::GraphDistances> engine[2];
+
+		DistanceCache(size_t memoryBudget, bool approximate): memoryBudget(memoryBudget), approximate(approximate), version(-1), nodeCount(-1), edgeCount(-1) {}
+	};
+	shared_ptr<DistanceCache> distanceCache;
+
+	//unique among all graphs and their copies; a new one is taken on every change
+	long long version;
+	static long long NextVersion();
+
+	//detaches the graph from the engines of its copies
+	void resetDistances(size_t memoryBudget, bool approximate)
+	{
+		distanceCache = shared_ptr<DistanceCache>(new DistanceCache(memoryBudget, approximate));
+	}
+
 public:
-	DotGraph(): initialized(false) {}
+	DotGraph(): initialized(false), distanceCache(new DistanceCache(distances::GraphDistances::DefaultMemoryBudget, false)), version(NextVersion()) {}
+
+	//input text viewed by the attributes of nodes and edges
+	shared_ptr<dotio::DotBuffer> buffer;
 
 	vector<DotNode*> style;
 
@@ -186,15 +231,20 @@ public:
 	map<string, vector<DotNode*> > clusters;
 	vector<vector<int> > adj;
 	vector<vector<int> > adjE;
-	map<pair<DotNode*, DotNode*>, DotEdge*> adjEdge;
+	struct NodePairHash
+	{
+		size_t operator () (const pair<DotNode*, DotNode*>& p) const
+		{
+			return hash<DotNode*>()(p.first) * 31 + hash<DotNode*>()(p.second);
+		}
+	};
+	unordered_map<pair<DotNode*, DotNode*>, DotEdge*, NodePairHash> adjEdge;
 
-	map<string, DotNode*> idToNode;
+	unordered_map<string, DotNode*> idToNode;
 	vector<int> nodeDegree;
 	vector<double> nodeWDegree;
-	map<pair<DotNode*, DotNode*>, int> shortestPaths;
-	map<pair<DotNode*, DotNode*>, double> shortestPathsW;
 
-	void AddDummyPoint(const Point& pos, const string& clusterId)
+	void AddDummyPoint(const Point& pos, const string& clusterId, const string& clusterColor)
 	{
 		DotNode* nn = new DotNode(nodes.size());
 
@@ -204,14 +254,37 @@ public:
 
 		stringstream ss;
 		ss << pos.x << "," << pos.y;
-		nn->attr["pos"] = ss.str();
+		nn->setAttr("pos", ss.str());
 		nn->setAttr("cluster", clusterId);
+		if (clusterColor != "")
+			nn->setAttr("clustercolor", clusterColor);
 		nn->setAttr("height", "0.0");
 		nn->setAttr("width", "0.0");
 		nn->setAttr("shape", "point");
 		nn->setAttr("style", "invis");
 
 		nodes.push_back(nn);
+		if (initialized)
+		{
+			adj.push_back(VI());
+			adjE.push_back(VI());
+		}
+		version = NextVersion();
+	}
+
+	//has to be called after the nodes or the edges (or their lengths) are changed directly;
+	//the adjacency lists, the degrees and the distances are computed again on the next use
+	void changed()
+	{
+		initialized = false;
+		adjEdge.clear();
+		idToNode.clear();
+		nodeDegree.clear();
+		nodeWDegree.clear();
+		for (int i = 0; i < (int)edges.size(); i++)
+			edges[i]->len = -1;
+
+		version = NextVersion();
 	}
 
 	void OutputStatistics()
@@ -226,7 +299,7 @@ public:
 			string c = to_string(i + first + 1);
 			for (int j = 0; j < (int)clust[i].size(); j++)
 			{
-				clust[i][j]->attr["cluster"] = c;
+				clust[i][j]->setAttr("cluster", c);
 				clust[i][j]->removeAttr("clustercolor");
 			}
 		}
@@ -285,6 +358,7 @@ public:
 	{
 		if (idToNode.empty())
 		{
+			idToNode.reserve(nodes.size());
 			for (int i = 0; i < (int)nodes.size(); i++)
 				idToNode[nodes[i]->id] = nodes[i];
 		}
@@ -328,33 +402,29 @@ public:
 		return nodeWDegree[node->index];
 	}
 
+	//returns -1 if the nodes are not connected
 	double getShortestPath(DotNode* s, DotNode* t, bool weighted)
 	{
-		pair<DotNode*, DotNode*> pair = make_pair(s, t);
-		if (weighted)
-		{
-			if (shortestPathsW.find(pair) == shortestPathsW.end())
-				initShortestPaths(s, true);
+		double d = getDistances(weighted).getDistance(s->index, t->index);
+		return (weighted ? d : (int)d);
+	}
 
-			return shortestPathsW[pair];
-		}
-		else
-		{
-			if (shortestPaths.find(pair) == shortestPaths.end())
-				initShortestPaths(s, false);
+	distances::GraphDistances& getDistances(bool weighted);
 
-			return shortestPaths[pair];
-		}
+	//memory (in bytes) available for the shortest-path cache; approximate distances are used
+	//for random queries if allowed and the full distance matrix does not fit
+	void setDistanceBudget(size_t memoryBudget, bool approximate)
+	{
+		resetDistances(memoryBudget, approximate);
 	}
 
-	void initShortestPaths(DotNode* s, bool weighted);
-
 	void initAdjacencyList()
 	{
 		if (initialized) return;
 
 		adj = VVI(nodes.size(), VI());
 		adjE = VVI(nodes.size(), VI());
+		adjEdge.reserve(2 * edges.size());
 		for (int i = 0; i < (int)edges.size(); i++)
 		{
 			DotNode* s = findNodeById(edges[i]->s);
@@ -471,6 +541,11 @@ public:
 		return g.getShortestPath(s, t, weighted);
 	}
 
+	distances::GraphDistances& getDistances(bool weighted)
+	{
+		return g.getDistances(weighted);
+	}
+
 	DotGraph getOriginalGraph() const
 	{
 		return g;
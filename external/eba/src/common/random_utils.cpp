@@ -6,14 +6,51 @@
 #include <ctime>
 #include <cmath>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 using namespace std;
 
+//every thread owns a generator producing the sequence of rand();
+//a thread that never calls InitRand behaves as after srand(1)
+#ifdef __GLIBC__
+struct RandState
+{
+	random_data data;
+	char buffer[128];
+
+	RandState()
+	{
+		memset(&data, 0, sizeof(data));
+		initstate_r(1, buffer, sizeof(buffer), &data);
+	}
+};
+
+thread_local RandState randState;
+
+void InitRand(int seed)
+{
+	srandom_r(seed, &randState.data);
+}
+
+int randRaw()
+{
+	int32_t result;
+	random_r(&randState.data, &result);
+	return result;
+}
+#else
 void InitRand(int seed)
 {
 	srand(seed);
 }
 
+int randRaw()
+{
+	return rand();
+}
+#endif
+
 void InitRand()
 {
 	InitRand((int)time(0));
@@ -21,11 +58,11 @@ void InitRand()
 
 int randInt()
 {
-	int result = rand();
+	int result = randRaw();
 	result <<= 15;
-	result += rand();
+	result += randRaw();
 	result <<= 2;
-	result += rand() % 4;
+	result += randRaw() % 4;
 	return result;
 }
 
@@ -166,6 +203,8 @@ vector<int> randPermutation(int size)
 	for (int i = 0; i < size; i++)
 		result[i] = i;
 
-	random_shuffle(result.begin(), result.end());
+	//the same swaps as random_shuffle
+	for (int i = 1; i < size; i++)
+		swap(result[i], result[randRaw() % (i + 1)]);
 	return result;
 }
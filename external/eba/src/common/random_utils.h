@@ -7,6 +7,9 @@ using namespace std;
 void InitRand(int seed);
 void InitRand();
 
+//the next value of the generator of the calling thread, in [0, RAND_MAX]
+int randRaw();
+
 int randInt();
 int randInt(int lower, int upper);
 int randInt(int upper);
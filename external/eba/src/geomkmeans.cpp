@@ -34,7 +34,7 @@ vector<DotNode*> GeometricKMeans::chooseCenters(ConnectedDotGraph& g, int K)
 {
 	vector<DotNode*> centers;
 
-	int i = rand() % g.nodes.size();
+	int i = randRaw() % g.nodes.size();
 	centers.push_back(g.nodes[i]);
 
 	for (int i = 1; i < K; i++)
@@ -3,18 +3,25 @@
 
 #include "clustering.h"
 
+VI nodeIndices(const vector<DotNode*>& nodes)
+{
+	VI res;
+	for (int i = 0; i < (int)nodes.size(); i++)
+		res.push_back(nodes[i]->index);
+	return res;
+}
+
 DotNode* GraphKMeans::getNextMean(const vector<DotNode*>& means, ConnectedDotGraph& g)
 {
+	//distances to the closest mean by a single multi-source run
+	VD dist;
+	VI closest;
+	g.getDistances(true).multiSourceDistances(nodeIndices(means), dist, closest);
+
 	VD minDist;
 	for (int i = 0; i < (int)g.nodes.size(); i++)
 	{
-		double minD = 123456789.0;
-		for (int j = 0; j < (int)means.size(); j++)
-		{
-			double d = g.getShortestPath(g.nodes[i], means[j], true);
-			minD = min(minD, d);
-		}
-
+		double minD = dist[g.nodes[i]->index];
 		minDist.push_back(Sqr2(minD));
 	}
 
@@ -42,20 +49,27 @@ vector<DotNode*> GraphKMeans::chooseCenters(ConnectedDotGraph& g, int K)
 
 DotNode* GraphKMeans::computeMedian(const vector<DotNode*>& group, ConnectedDotGraph& g)
 {
-	double dmin = -1;
-	int bestIndex = -1;
-	for (int i = 0; i < (int)group.size(); i++)
+	//eccentricity of every node within the group
+	VI indices = nodeIndices(group);
+	VD ecc(group.size(), -1);
+	g.getDistances(true).forEachRow(indices, [&](int i, const float* row)
 	{
 		double mx = -1;
-		for (int j = 0; j < (int)group.size(); j++)
+		for (int j = 0; j < (int)indices.size(); j++)
 		{
-			double d = g.getShortestPath(group[i], group[j], true);
+			double d = row[indices[j]];
 			if (mx == -1 || mx < d) mx = d;
 		}
+		ecc[i] = mx;
+	});
 
-		if (dmin == -1 || dmin > mx)
+	double dmin = -1;
+	int bestIndex = -1;
+	for (int i = 0; i < (int)group.size(); i++)
+	{
+		if (dmin == -1 || dmin > ecc[i])
 		{
-			dmin = mx;
+			dmin = ecc[i];
 			bestIndex = i;
 		}
 	}
@@ -74,23 +88,17 @@ ClusteringInfo GraphKMeans::groupPoints(const vector<DotNode*>& means, Connected
 	{
 		groups = VVN(median.size(), VN());
 
+		//assign every node to the closest mean (the first one in case of ties)
+		VD dist;
+		VI closest;
+		g.getDistances(true).multiSourceDistances(nodeIndices(means), dist, closest);
+
 		for (int i = 0; i < (int)g.nodes.size(); i++)
 		{
-			double minDis = 123456789.0;
-			int bestIndex = -1;
-
-			for (int j = 0; j < (int)means.size(); j++)
-			{
-				double d = g.getShortestPath(g.nodes[i], means[j], true);
-				if (minDis > d)
-				{
-					minDis = d;
-					bestIndex = j;
-				}
-			}
+			int bestIndex = closest[g.nodes[i]->index];
 
 			assert(bestIndex != -1);
-			assert(minDis < 1234567.0);
+			assert(dist[g.nodes[i]->index] < 1234567.0);
 			groups[bestIndex].push_back(g.nodes[i]);
 		}
 
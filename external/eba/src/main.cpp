@@ -5,6 +5,8 @@
 #include "common/graph/dot_graph.h"
 #include "common/graph/dot_parser.h"
 
+#include "profile/profile.h"
+
 #include "clustering.h"
 #include "metrics.h"
 
@@ -35,60 +37,68 @@ void PrepareCMDOptions(int argc, char** argv, CMDOptions& args)
 
 	args.AddAllowedOption("-K", "", "Desired number of clusters (selected automatically, if no value is supplied)");
 
+	args.AddAllowedOption("-louvain", "serial", "Local moving of modularity clustering: move the nodes one by one or compute their moves in parallel batches (with the same result)");
+	args.AddAllowedValue("-louvain", "serial");
+	args.AddAllowedValue("-louvain", "parallel");
+
+	args.AddAllowedOption("-metrics", "exact", "Algorithms for computing layout metrics; 'large' is not limited in the size of the graph");
+	args.AddAllowedValue("-metrics", "exact");
+	args.AddAllowedValue("-metrics", "large");
+	args.AddAllowedOption("-samples", "0", "The number of sampled nodes for estimating pairwise metrics in the 'large' mode (all nodes, if 0)");
+
+	args.AddAllowedOption("-memory", "1024", "Memory limit (in MB) for caching graph-theoretic distances");
+	args.AddAllowedOption("-distances", "exact", "Whether graph-theoretic distances may be approximated when all of them do not fit into the memory limit");
+	args.AddAllowedValue("-distances", "exact");
+	args.AddAllowedValue("-distances", "approximate");
+
+	args.AddAllowedOption("--profile", "Write the wall time, the peak memory and the event counters of every stage to stderr as JSON");
+
 	args.Parse(argc, argv);
+
+	if (args.hasOption("--profile"))
+		profile::Enable();
 }
 
-void MetricsAction(const CMDOptions& options)
+void PrepareDistances(const CMDOptions& options, DotGraph& g)
+{
+	size_t memoryBudget = (size_t)toInt(options.getOption("-memory")) * 1024 * 1024;
+	bool approximate = (options.getOption("-distances") == "approximate");
+	g.setDistanceBudget(memoryBudget, approximate);
+}
+
+DotGraph ReadGraph(const CMDOptions& options)
 {
+	profile::Stage stage("read");
+
 	DotReader parser;
-	DotGraph g = parser.ReadGraph(options.getOption(""));
+	return parser.ReadGraph(options.getOption(""));
+}
+
+void MetricsAction(const CMDOptions& options)
+{
+	DotGraph g = ReadGraph(options);
+	PrepareDistances(options, g);
 
 	Metrics m;
+	m.largeGraph = (options.getOption("-metrics") == "large");
+	m.samples = toInt(options.getOption("-samples"));
 	m.Compute(g);
+
+	profile::Stage stage("write");
 	m.Output(options.getOption("-o"));
 }
 
 void ClusteringAction(const CMDOptions& options)
 {
-	DotReader parser;
-	DotGraph g = parser.ReadGraph(options.getOption(""));
-
-	string algoName = options.getOption("-C");
-	ClusterAlgorithm* algo = NULL;
-
-	if (algoName == "geometrickmeans")
-		algo = new GeometricKMeans();
-	else if (algoName == "graphkmeans")
-		algo = new GraphKMeans();
-	else if (algoName == "geometrichierarchical")
-		algo = new GeometricHierarchical();
-	else if (algoName == "graphhierarchical")
-		algo = new GraphHierarchical();
-	else if (algoName == "infomap")
-		algo = new InfoMap();
-	else if (algoName == "modularity")
-		algo = new Modularity(false);
-	else if (algoName == "modularity-cont")
-		algo = new Modularity(true);
-
-	string numberOfClusters = options.getOption("-K");
-	if (numberOfClusters == "graph")
-	{
-		int k = g.ClusterCount();
-		algo->cluster(g, k);
-	}
-	else if (numberOfClusters == "")
-	{
-		algo->cluster(g);
-	}
-	else
+	DotGraph g = ReadGraph(options);
+	PrepareDistances(options, g);
+
 	{
-		int k = toInt(numberOfClusters);
-		algo->cluster(g, k);
+		profile::Stage stage("clustering");
+		ClusterGraph(g, options.getOption("-C"), options.getOption("-K"), options.getOption("-louvain") == "parallel");
 	}
 
-	delete algo;
-
+	profile::Stage stage("write");
 	DotWriter writer;
 	writer.WriteGraph(options.getOption("-o"), g);
 }
@@ -118,5 +128,6 @@ int main(int argc, char **argv)
 		returnCode = code;
 	}
 
+	profile::Report("kmeans", argc, argv);
 	return returnCode;
 }
@@ -1,35 +1,12 @@
 #include "metrics.h"
 
 #include "common/geometry/segment.h"
+#include "common/random_utils.h"
 
-#include <algorithm>
-
-void findAverageDistances(DotGraph& g, double& avgGeom, double& avgIdeal)
-{
-	avgGeom = 0;
-	avgIdeal = 0;
-	double cnt = 0;
-
-	for (int i = 0; i < (int)g.nodes.size(); i++)
-		for (int j = i + 1; j < (int)g.nodes.size(); j++)
-		{
-			DotNode* s = g.nodes[i];
-			DotNode* t = g.nodes[j];
-
-			double geomDistance = s->getPos().Distance(t->getPos());
-			double idealDistance = g.getShortestPath(s, t, true);
-			//not connected
-			if (idealDistance < 0) continue;
+#include "spatial/kd_tree.h"
+#include "profile/profile.h"
 
-			avgGeom += geomDistance;
-			avgIdeal += idealDistance;
-			cnt++;
-		}
-
-	avgGeom /= cnt;
-	avgIdeal /= cnt;
-	assert(avgGeom > EPS && avgIdeal > EPS);
-}
+#include <algorithm>
 
 double computeMdsStressRelative(DotGraph& g)
 {
@@ -105,151 +82,303 @@ double computeSparseStress(DotGraph& g)
 	return sqrt(mdsStress);
 }
 
-double computeScalingFactor(DotGraph& g)
+vector<Point> nodePositions(DotGraph& g)
 {
-	double num = 0;
-	double den = 0;
-
+	vector<Point> pos;
 	for (int i = 0; i < (int)g.nodes.size(); i++)
-		for (int j = i + 1; j < (int)g.nodes.size(); j++)
-		{
-			DotNode* s = g.nodes[i];
-			DotNode* t = g.nodes[j];
+		pos.push_back(g.nodes[i]->getPos());
+	return pos;
+}
+
+//calls f(k, row) for every sources[k]; the calls are concurrent
+template<class F>
+void forEachRowParallel(distances::GraphDistances& dist, const VI& sources, F f)
+{
+	dist.forEachBlock(sources, [&](int first, const vector<const float*>& rows)
+	{
+		#pragma omp parallel for schedule(dynamic)
+		for (int k = 0; k < (int)rows.size(); k++)
+			f(first + k, rows[k]);
+	});
+}
+
+//sums over pairs of connected nodes; g and d are geometric and graph-theoretic distances
+struct PairSums
+{
+	double cnt;
+	double geom, ideal;
+	double geom2, ideal2, prod;
+	//sums of g/d and (g/d)^2
+	double ratio, ratio2;
+
+	PairSums(): cnt(0), geom(0), ideal(0), geom2(0), ideal2(0), prod(0), ratio(0), ratio2(0) {}
+
+	void add(double g, double d)
+	{
+		cnt++;
+		geom += g;
+		ideal += d;
+		geom2 += g * g;
+		ideal2 += d * d;
+		prod += g * d;
+		ratio += g / d;
+		ratio2 += Sqr2(g) / Sqr2(d);
+	}
+
+	void add(const PairSums& o)
+	{
+		cnt += o.cnt;
+		geom += o.geom;
+		ideal += o.ideal;
+		geom2 += o.geom2;
+		ideal2 += o.ideal2;
+		prod += o.prod;
+		ratio += o.ratio;
+		ratio2 += o.ratio2;
+	}
+
+	//stress after the optimal scaling s = ratio / ratio2, that is, sum (s*g - d)^2 / d^2
+	double stress() const
+	{
+		return cnt - Sqr2(ratio) / ratio2;
+	}
+
+	//normalized correlation of g and d
+	double distortion() const
+	{
+		double sumAB = prod - geom * ideal / cnt;
+		double sumA = geom2 - geom * geom / cnt;
+		double sumB = ideal2 - ideal * ideal / cnt;
 
-			double geomDistance = s->getPos().Distance(t->getPos());
-			double idealDistance = g.getShortestPath(s, t, true);
+		if (Abs(sumAB) < EPS) return 0.5;
+		return (1.0 + sumAB / (sqrt(sumA) * sqrt(sumB))) / 2.0;
+	}
+};
+
+//exact full stress and distortion over all pairs of nodes
+void computeStressDistortion(DotGraph& g, double& fullStress, double& distortion)
+{
+	fullStress = distortion = UNDEF;
+	if (g.edges.size() <= 0) return;
+
+	int n = (int)g.nodes.size();
+	vector<Point> pos = nodePositions(g);
+	VI sources;
+	for (int i = 0; i < n; i++)
+		sources.push_back(g.nodes[i]->index);
+
+	distances::GraphDistances& dist = g.getDistances(true);
+
+	//scaling factor and average distances
+	vector<PairSums> rowSums(n);
+	forEachRowParallel(dist, sources, [&](int i, const float* row)
+	{
+		for (int j = i + 1; j < n; j++)
+		{
+			double idealDistance = row[sources[j]];
 			//not connected
 			if (idealDistance < 0) continue;
 
-			num += geomDistance / idealDistance;
 			assert(idealDistance > EPS);
-			den += Sqr2(geomDistance) / Sqr2(idealDistance);
+			rowSums[i].add(pos[i].Distance(pos[j]), idealDistance);
 		}
+	});
 
-	assert(Abs(den) > EPS);
-	return num / den;
-}
-
-double computeFullStress(DotGraph& g)
-{
-	if (g.edges.size() <= 0) return UNDEF;
+	PairSums total;
+	for (int i = 0; i < n; i++)
+		total.add(rowSums[i]);
 
-	double s = computeScalingFactor(g);
+	assert(Abs(total.ratio2) > EPS);
+	double s = total.ratio / total.ratio2;
 	assert(s > 0.0);
-	double stress = 0;
-	for (int i = 0; i < (int)g.nodes.size(); i++)
-		for (int j = i + 1; j < (int)g.nodes.size(); j++)
-		{
-			DotNode* sn = g.nodes[i];
-			DotNode* tn = g.nodes[j];
+	double avgGeom = total.geom / total.cnt;
+	double avgIdeal = total.ideal / total.cnt;
+	assert(avgGeom > EPS && avgIdeal > EPS);
 
-			double geomDistance = sn->getPos().Distance(tn->getPos());
-			double idealDistance = g.getShortestPath(sn, tn, true);
+	//stress and correlation
+	VD stress(n, 0), sumAB(n, 0), sumA(n, 0), sumB(n, 0);
+	forEachRowParallel(dist, sources, [&](int i, const float* row)
+	{
+		for (int j = i + 1; j < n; j++)
+		{
+			double idealDistance = row[sources[j]];
 			//not connected
 			if (idealDistance < 0) continue;
 
-			double delta = s * geomDistance - idealDistance;
-			stress += Sqr2(delta) / Sqr2(idealDistance);
+			double geomDistance = pos[i].Distance(pos[j]);
+			stress[i] += Sqr2(s * geomDistance - idealDistance) / Sqr2(idealDistance);
+			sumAB[i] += (geomDistance - avgGeom) * (idealDistance - avgIdeal);
+			sumA[i] += (geomDistance - avgGeom) * (geomDistance - avgGeom);
+			sumB[i] += (idealDistance - avgIdeal) * (idealDistance - avgIdeal);
 		}
+	});
+
+	fullStress = Sum(stress);
 
-	return stress;
+	double AB = Sum(sumAB);
+	if (Abs(AB) < EPS)
+		distortion = 0.5;
+	else
+		distortion = (1.0 + AB / (sqrt(Sum(sumA)) * sqrt(Sum(sumB)))) / 2.0;
 }
 
-double computeDistortion(DotGraph& g)
+//0.975-quantile of Student's t-distribution with df degrees of freedom
+double studentQuantile(int df)
 {
-	if (g.edges.size() <= 0) return UNDEF;
+	static const double table[30] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+	if (df <= 30) return table[df - 1];
+
+	//expansion around the normal quantile
+	double z = 1.959964;
+	return z + (z * z * z + z) / (4.0 * df) + (5.0 * pow(z, 5) + 16.0 * z * z * z + 3.0 * z) / (96.0 * df * df);
+}
 
-	double avgGeom = 0;
-	double avgIdeal = 0;
-	findAverageDistances(g, avgGeom, avgIdeal);
+//half-width of the 95% confidence interval for the mean of the values (estimates with a
+//t-distribution); the sample is drawn without replacement, the given fraction of the population
+double confidenceBound(const VD& values, double samplingFraction)
+{
+	int k = (int)values.size();
+	if (k <= 1) return 0;
 
-	double sumAB = 0, sumA = 0, sumB = 0;
-	for (int i = 0; i < (int)g.nodes.size(); i++)
-		for (int j = i + 1; j < (int)g.nodes.size(); j++)
-		{
-			DotNode* s = g.nodes[i];
-			DotNode* t = g.nodes[j];
+	double mean = Average(values);
+	double var = 0;
+	for (int i = 0; i < k; i++)
+		var += Sqr2(values[i] - mean);
+	var /= (k - 1);
+
+	double fpc = max(0.0, 1.0 - samplingFraction);
+	return studentQuantile(k - 1) * sqrt(var * fpc / k);
+}
+
+//random subset of nodes
+VI sampleSources(DotGraph& g, int samples)
+{
+	VI perm = randPermutation((int)g.nodes.size());
+	VI res;
+	for (int i = 0; i < samples && i < (int)perm.size(); i++)
+		res.push_back(g.nodes[perm[i]]->index);
 
-			double geomDistance = s->getPos().Distance(t->getPos());
-			double idealDistance = g.getShortestPath(s, t, true);
+	sort(res.begin(), res.end());
+	return res;
+}
+
+//full stress and distortion estimated from the rows of sampled pivots;
+//error bounds are derived from the estimates on disjoint batches of pivots
+void estimateStressDistortion(DotGraph& g, const VI& sources, double& fullStress, double& stressError, double& distortion, double& distortionError)
+{
+	fullStress = distortion = stressError = distortionError = UNDEF;
+	if (g.edges.size() <= 0) return;
+
+	int n = (int)g.nodes.size();
+	int k = (int)sources.size();
+	vector<Point> pos = nodePositions(g);
+
+	vector<PairSums> rowSums(k);
+	forEachRowParallel(g.getDistances(true), sources, [&](int i, const float* row)
+	{
+		int s = sources[i];
+		for (int j = 0; j < n; j++)
+		{
+			double idealDistance = row[j];
 			//not connected
-			if (idealDistance < 0) continue;
+			if (j == s || idealDistance < 0) continue;
 
-			sumAB += (geomDistance - avgGeom) * (idealDistance - avgIdeal);
-			sumA += (geomDistance - avgGeom) * (geomDistance - avgGeom);
-			sumB += (idealDistance - avgIdeal) * (idealDistance - avgIdeal);
+			rowSums[i].add(pos[s].Distance(pos[j]), idealDistance);
 		}
+	});
 
-	if (Abs(sumAB) < EPS) return 0.5;
+	//stress is a sum over unordered pairs; every pair appears twice among all n rows
+	PairSums total;
+	for (int i = 0; i < k; i++)
+		total.add(rowSums[i]);
+	fullStress = total.stress() * (double)n / (2.0 * k);
+	distortion = total.distortion();
 
-	double distortion = sumAB / (sqrt(sumA) * sqrt(sumB));
-	//normalizing
-	return (1.0 + distortion) / 2.0;
-}
+	int batchCount = min(10, k);
+	if (batchCount <= 1) return;
 
-vector<DotNode*> findClosestNodes(DotGraph& g, int K, DotNode* s)
-{
-	vector<pair<double, DotNode*> > distances;
-	for (int i = 0; i < (int)g.nodes.size(); i++)
+	VD stressEst, distortionEst;
+	for (int b = 0; b < batchCount; b++)
 	{
-		DotNode* t = g.nodes[i];
-		distances.push_back(make_pair(s->getPos().Distance(t->getPos()), t));
+		PairSums batch;
+		int size = 0;
+		for (int i = b; i < k; i += batchCount)
+		{
+			batch.add(rowSums[i]);
+			size++;
+		}
+
+		stressEst.push_back(batch.stress() * (double)n / (2.0 * size));
+		distortionEst.push_back(batch.distortion());
 	}
 
-	sort(distances.begin(), distances.end());
-	vector<DotNode*> res;
-	for (int i = 0; i < (int)distances.size() && i < K; i++)
-		res.push_back(distances[i].second);
-	return res;
+	//the total estimate is (roughly) the mean of the batch estimates over all k pivots
+	stressError = confidenceBound(stressEst, (double)k / n);
+	distortionError = confidenceBound(distortionEst, (double)k / n);
 }
 
-double computeThreshold(DotGraph& g, int K, DotNode* s)
+//K-th smallest graph-theoretic distance from the source of the row
+double computeThreshold(const float* row, int n, int K)
 {
-	vector<pair<double, DotNode*> > distances;
-	for (int i = 0; i < (int)g.nodes.size(); i++)
+	VD distances;
+	for (int t = 0; t < n; t++)
 	{
-		DotNode* t = g.nodes[i];
-		double sp = g.getShortestPath(s, t, true);
-		if (sp == -1) continue;
-		distances.push_back(make_pair(sp, t));
+		if (row[t] == -1) continue;
+		distances.push_back(row[t]);
 	}
 
-	sort(distances.begin(), distances.end());
-	if ((int)distances.size() <= K) return distances.back().first;
-	return distances[K - 1].first;
+	if ((int)distances.size() <= K) return *max_element(distances.begin(), distances.end());
+	nth_element(distances.begin(), distances.begin() + K - 1, distances.end());
+	return distances[K - 1];
 }
 
-double computeNeigPreservation(DotGraph& g)
+//average over the given nodes; if the nodes are a sample, error is the 95% confidence bound
+double computeNeigPreservation(DotGraph& g, const VI& sources, double& error)
 {
 	int K = 20;
+	error = UNDEF;
 	if (g.edges.size() <= 0) return UNDEF;
 
-	double np = 0, cnt = 0;
-	for (int i = 0; i < (int)g.nodes.size(); i++)
-	{
-		DotNode* s = g.nodes[i];
+	int n = (int)g.nodes.size();
+	vector<Point> pos = nodePositions(g);
+	spatial::KdTree index(pos);
+
+	//K geometrically closest nodes of every source (including itself), ordered by distance and index
+	vector<Point> sourcePos;
+	for (int i = 0; i < (int)sources.size(); i++)
+		sourcePos.push_back(pos[sources[i]]);
+	vector<vector<spatial::Neighbor> > closestNodes;
+	index.nearestBatch(sourcePos, K, closestNodes);
 
-		vector<DotNode*> closestNodes = findClosestNodes(g, K, s);
-		double threshold = computeThreshold(g, K, s);
+	VD np(sources.size(), -1);
+	forEachRowParallel(g.getDistances(true), sources, [&](int i, const float* row)
+	{
+		double threshold = computeThreshold(row, n, K);
 
 		double good = 0, all = 0;
-		for (int j = 0; j < (int)closestNodes.size(); j++)
+		for (int j = 0; j < (int)closestNodes[i].size(); j++)
 		{
-			double sp = g.getShortestPath(s, closestNodes[j], true);
+			double sp = row[closestNodes[i][j].index];
 
 			if (sp != -1 && sp <= threshold) good++;
 			all++;
 		}
 
 		if (all > 0)
-		{
-			np += good / all;
-			cnt++;
-		}
-	}
+			np[i] = good / all;
+	});
 
-	if (cnt == 0) return UNDEF;
-	return np / cnt;
+	VD values;
+	for (int i = 0; i < (int)np.size(); i++)
+		if (np[i] != -1) values.push_back(np[i]);
+
+	if (values.empty()) return UNDEF;
+	if ((int)sources.size() < n)
+		error = confidenceBound(values, (double)values.size() / n);
+	return Average(values);
 }
 
 Rectangle computeBoundingBox(const DotGraph& g)
@@ -271,6 +400,8 @@ Rectangle computeBoundingBox(const DotGraph& g)
 	return Rectangle(pLB, pRT);
 }
 
+//the entropy of the distribution of the nodes over a grid of about n cells, relative to the
+//uniform one; every node is put into the cell (half-open, the last one closed) containing it
 double computeUniform(const DotGraph& g)
 {
 	Rectangle bb = computeBoundingBox(g);
@@ -278,28 +409,30 @@ double computeUniform(const DotGraph& g)
 	//number of cells
 	int W = (int)sqrt((double)g.nodes.size() + 1.0);
 	int H = (int)sqrt((double)g.nodes.size() + 1.0);
+	double cellWidth = bb.getWidth() / W;
+	double cellHeight = bb.getHeight() / H;
 
-	double entropy = 0;
-	for (int i = 0; i < W; i++)
-		for (int j = 0; j < H; j++)
-		{
-			double cellWidth = bb.getWidth() / W;
-			double cellHeight = bb.getHeight() / H;
-			Rectangle cell(bb.xl + cellWidth * i, bb.yl + cellHeight * j, bb.xl + cellWidth * (i + 1), bb.yl + cellHeight * (j + 1));
-
-			//observed frequency (words inside cell)
-			double p = 0;
-			for (int k = 0; k < (int)g.nodes.size(); k++)
-				if (cell.Contains(g.nodes[k]->getPos())) p++;
+	VI count(W * H, 0);
+	for (int k = 0; k < (int)g.nodes.size(); k++)
+	{
+		Point p = g.nodes[k]->getPos();
+		int i = (cellWidth > 0 ? min(W - 1, (int)((p.x - bb.xl) / cellWidth)) : 0);
+		int j = (cellHeight > 0 ? min(H - 1, (int)((p.y - bb.yl) / cellHeight)) : 0);
+		count[i * H + j]++;
+	}
 
-			p /= (double)g.nodes.size();
-			if (Abs(p) < EPS) continue;
+	double entropy = 0;
+	for (int c = 0; c < W * H; c++)
+	{
+		//observed frequency (words inside cell)
+		double p = (double)count[c] / (double)g.nodes.size();
+		if (Abs(p) < EPS) continue;
 
-			//expected frequency
-			double q = (double) 1.0 / (W * H);
+		//expected frequency
+		double q = (double) 1.0 / (W * H);
 
-			entropy += p * log(p / q);
-		}
+		entropy += p * log(p / q);
+	}
 
 	double maxEntropy = log((double)g.nodes.size());
 
@@ -320,37 +453,129 @@ double computeAspectRatio(const DotGraph& g)
 	return mx / mn;
 }
 
-double computeCrossings(DotGraph& g, double& minCrossAngle, double& avgCrossAngle)
+//edge crossings found with a uniform grid: every edge is put into the cells crossed by its
+//segment (widened by the tolerance), and a pair of edges is tested only in the first cell
+//crossed by both of them, so that it is tested once
+double computeCrossingsGrid(DotGraph& g, double& minCrossAngle, double& avgCrossAngle)
 {
 	minCrossAngle = avgCrossAngle = UNDEF;
 	if (g.nodes.size() <= 0) return UNDEF;
-	if (g.edges.size() > 1000) return UNDEF;
 
-	VD crossAngles;
-	int cr = 0;
-	for (int i = 0; i < (int)g.edges.size(); i++)
-		for (int j = i + 1; j < (int)g.edges.size(); j++)
-		{
-			DotEdge* e1 = g.edges[i];
-			DotEdge* e2 = g.edges[j];
+	int m = (int)g.edges.size();
+	vector<Point> src(m), dst(m);
+	vector<Rectangle> box(m);
+	VD margin(m);
+	for (int i = 0; i < m; i++)
+	{
+		src[i] = g.findNodeById(g.edges[i]->s)->getPos();
+		dst[i] = g.findNodeById(g.edges[i]->t)->getPos();
 
-			DotNode* s1 = g.findNodeById(e1->s);
-			DotNode* t1 = g.findNodeById(e1->t);
-			DotNode* s2 = g.findNodeById(e2->s);
-			DotNode* t2 = g.findNodeById(e2->t);
+		//intersections are detected with a tolerance
+		margin[i] = 1e-6 * (1.0 + src[i].Distance(dst[i]));
+		box[i] = Rectangle(min(src[i].x, dst[i].x) - margin[i], max(src[i].x, dst[i].x) + margin[i], min(src[i].y, dst[i].y) - margin[i], max(src[i].y, dst[i].y) + margin[i]);
+	}
 
-			if (Segment::EdgesIntersect(s1->getPos(), t1->getPos(), s2->getPos(), t2->getPos()))
+	if (m == 0)
+	{
+		minCrossAngle = avgCrossAngle = 0;
+		return 0;
+	}
+
+	Rectangle bb = box[0];
+	for (int i = 1; i < m; i++)
+		bb.Add(box[i]);
+
+	int G = max(1, (int)sqrt((double)m));
+	double cellWidth = max(bb.getWidth() / G, EPS);
+	double cellHeight = max(bb.getHeight() / G, EPS);
+	auto cellX = [&](double x) { return max(0, min(G - 1, (int)((x - bb.xl) / cellWidth))); };
+	auto cellY = [&](double y) { return max(0, min(G - 1, (int)((y - bb.yl) / cellHeight))); };
+
+	//the cells of every edge (in increasing order): in every column of its box, the rows
+	//between the heights of the segment at the sides of the column
+	VI cellBegin(m + 1, 0);
+	VI edgeCells;
+	for (int i = 0; i < m; i++)
+	{
+		const Point& a = (src[i].x <= dst[i].x ? src[i] : dst[i]);
+		const Point& b = (src[i].x <= dst[i].x ? dst[i] : src[i]);
+		double slope = (b.x - a.x > EPS ? (b.y - a.y) / (b.x - a.x) : 0);
+
+		int x0 = cellX(box[i].xl), x1 = cellX(box[i].xr);
+		for (int x = x0; x <= x1; x++)
+		{
+			double yl = box[i].yl, yr = box[i].yr;
+			if (b.x - a.x > EPS)
 			{
-				cr++;
-				double angle = Segment::CrossingAngle(s1->getPos(), t1->getPos(), s2->getPos(), t2->getPos());
-				assert(angle >= 0.0 && angle <= 1.5707963268);
-				crossAngles.push_back(angle);
+				double xl = max(a.x, bb.xl + cellWidth * x - margin[i]), xr = min(b.x, bb.xl + cellWidth * (x + 1) + margin[i]);
+				if (x == x0) xl = a.x;
+				if (x == x1) xr = b.x;
+				double ya = a.y + slope * (xl - a.x), yb = a.y + slope * (xr - a.x);
+				yl = max(yl, min(ya, yb) - margin[i]);
+				yr = min(yr, max(ya, yb) + margin[i]);
 			}
+
+			for (int y = cellY(yl); y <= cellY(yr); y++)
+				edgeCells.push_back(x * G + y);
 		}
+		cellBegin[i + 1] = (int)edgeCells.size();
+	}
+
+	VVI cells(G * G);
+	for (int i = 0; i < m; i++)
+		for (int k = cellBegin[i]; k < cellBegin[i + 1]; k++)
+			cells[edgeCells[k]].push_back(i);
+
+	//whether edges i and j cross a common cell before c
+	auto sharedBefore = [&](int i, int j, int c)
+	{
+		if (cellBegin[i + 1] - cellBegin[i] > cellBegin[j + 1] - cellBegin[j]) swap(i, j);
+		auto first = edgeCells.begin() + cellBegin[j];
+		auto last = edgeCells.begin() + cellBegin[j + 1];
+		for (int k = cellBegin[i]; k < cellBegin[i + 1] && edgeCells[k] < c; k++)
+			if (binary_search(first, last, edgeCells[k])) return true;
+		return false;
+	};
+
+	long long cr = 0;
+	double sumAngle = 0;
+	double minAngle = INF;
+	#pragma omp parallel for schedule(dynamic) reduction(+:cr, sumAngle) reduction(min:minAngle)
+	for (int c = 0; c < G * G; c++)
+	{
+		const VI& cell = cells[c];
+		for (int a = 0; a < (int)cell.size(); a++)
+			for (int b = a + 1; b < (int)cell.size(); b++)
+			{
+				int i = cell[a];
+				int j = cell[b];
+				if (!box[i].Intersects(box[j])) continue;
+				if (sharedBefore(i, j, c)) continue;
+
+				if (Segment::EdgesIntersect(src[i], dst[i], src[j], dst[j]))
+				{
+					cr++;
+					double angle = Segment::CrossingAngle(src[i], dst[i], src[j], dst[j]);
+					assert(angle >= 0.0 && angle <= 1.5707963268);
+					sumAngle += angle;
+					minAngle = min(minAngle, angle);
+				}
+			}
+	}
 
-	minCrossAngle = Minimum(crossAngles);
-	avgCrossAngle = Average(crossAngles);
-	return cr;
+	minCrossAngle = (cr > 0 ? minAngle : 0);
+	avgCrossAngle = (cr > 0 ? sumAngle / cr : 0);
+	return (double)cr;
+}
+
+//crossings are not reported for graphs with more than 1000 edges unless the large-graph mode is on
+double computeCrossings(DotGraph& g, double& minCrossAngle, double& avgCrossAngle)
+{
+	minCrossAngle = avgCrossAngle = UNDEF;
+	if (g.nodes.size() <= 0) return UNDEF;
+	if (g.edges.size() > 1000) return UNDEF;
+
+	return computeCrossingsGrid(g, minCrossAngle, avgCrossAngle);
 }
 
 double computeModularity(DotGraph& g)
@@ -547,17 +772,49 @@ void Metrics::ComputeLayout(DotGraph& g)
 	m = g.edges.size();
 	c = g.ClusterCount();
 
-	sparseStress = computeSparseStress(g);
-	fullStress = computeFullStress(g);
-	distortion = computeDistortion(g);
-	neigPreservation = computeNeigPreservation(g);
-	uniform = computeUniform(g);
-	aspectRatio = computeAspectRatio(g);
-	crossings = computeCrossings(g, minCrossAngle, avgCrossAngle);
+	{
+		profile::Stage stage("metrics/sparse_stress");
+		sparseStress = computeSparseStress(g);
+	}
+
+	VI sources;
+	{
+		profile::Stage stage("metrics/stress_distortion");
+		if (largeGraph && samples > 0 && samples < n)
+		{
+			//estimate pairwise measures on a sample of nodes
+			sources = sampleSources(g, samples);
+			estimateStressDistortion(g, sources, fullStress, fullStressError, distortion, distortionError);
+		}
+		else
+		{
+			for (int i = 0; i < (int)g.nodes.size(); i++)
+				sources.push_back(g.nodes[i]->index);
+			computeStressDistortion(g, fullStress, distortion);
+		}
+	}
+
+	{
+		profile::Stage stage("metrics/neighborhood_preservation");
+		neigPreservation = computeNeigPreservation(g, sources, neigPreservationError);
+	}
+
+	{
+		profile::Stage stage("metrics/uniformity");
+		uniform = computeUniform(g);
+		aspectRatio = computeAspectRatio(g);
+	}
+
+	profile::Stage stage("metrics/crossings");
+	if (largeGraph)
+		crossings = computeCrossingsGrid(g, minCrossAngle, avgCrossAngle);
+	else
+		crossings = computeCrossings(g, minCrossAngle, avgCrossAngle);
 }
 
 void Metrics::ComputeCluster(DotGraph& g)
 {
+	profile::Stage stage("metrics/cluster");
 	modularity = computeModularityFast(g);
 	//modularity = computeModularity(g);
 	coverage = computeCoverage(g);
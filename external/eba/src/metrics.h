@@ -26,8 +26,21 @@ public:
 	double conductance;
 	double contiguity;
 
+	//95% confidence bounds of the sampled estimates
+	double fullStressError;
+	double distortionError;
+	double neigPreservationError;
+
+	//whether to use the algorithms for large graphs (no limit on the number of edges for crossings);
+	//if samples is positive, pairwise measures are estimated on that many sampled nodes
+	bool largeGraph;
+	int samples;
+
 	Metrics()
 	{
+		largeGraph = false;
+		samples = 0;
+
 		sparseStress = UNDEF;
 		fullStress = UNDEF;
 		distortion = UNDEF;
@@ -42,6 +55,10 @@ public:
 		coverage = UNDEF;
 		conductance = UNDEF;
 		contiguity = UNDEF;
+
+		fullStressError = UNDEF;
+		distortionError = UNDEF;
+		neigPreservationError = UNDEF;
 	}
 
 	void OutputLayout(const string& filename) const
@@ -79,9 +96,9 @@ public:
 		out << "|V| = " << n << "   |E| = " << m << "   |C| = " << c << "\n";
 
 		out << "Sparse-Stress:              " << safeString(sparseStress) << "\n";
-		out << "Full-Stress:                " << safeString(fullStress) << "\n";
-		out << "Distortion:                 " << safeString(distortion) << "\n";
-		out << "Neighborhood Preservation:  " << safeString(neigPreservation) << "\n";
+		out << "Full-Stress:                " << safeString(fullStress, fullStressError) << "\n";
+		out << "Distortion:                 " << safeString(distortion, distortionError) << "\n";
+		out << "Neighborhood Preservation:  " << safeString(neigPreservation, neigPreservationError) << "\n";
 		out << "Uniform Area Utilization:   " << safeString(uniform) << "\n";
 		out << "Aspect Ratio:               " << safeString(aspectRatio) << "\n";
 		out << "Crossings:                  " << safeString(crossings) << "\n";
@@ -124,6 +141,12 @@ public:
 		return ss.str();
 	}
 
+	string safeString(double value, double error) const
+	{
+		if (value == UNDEF || error == UNDEF) return safeString(value);
+		return safeString(value) + " (+/- " + safeString(error) + ")";
+	}
+
 	void ComputeLayout(DotGraph& g);
 	void ComputeCluster(DotGraph& g);
 	void Compute(DotGraph& g);
@@ -1,20 +1,38 @@
 #include "metrics.h"
 
-#include "common/geometry/delaunay_triangulation.h"
+#include "common/geometry/delaunay_mesh.h"
 
 using namespace geometry;
 
 double computeContiguity(DotGraph& g)
 {
-	vector<double> error;
-	for (auto cl : g.GetClusters())
+	auto clusterMap = g.GetClusters();
+	vector<pair<string, vector<DotNode*> > > clusters(clusterMap.begin(), clusterMap.end());
+
+	// the attributes are parsed (and cached by the nodes) before the parallel loop
+	vector<Point> positions;
+	vector<string> nodeClusters;
+	for (auto node : g.nodes)
+	{
+		positions.push_back(node->getPos());
+		nodeClusters.push_back(node->getCluster());
+	}
+
+	vector<vector<Rectangle> > rects(clusters.size());
+	for (int i = 0; i < (int)clusters.size(); i++)
+		for (auto node : clusters[i].second)
+			rects[i].push_back(node->getBoundingRectangle());
+
+	// error[i] < 0 for the clusters with at most two corners
+	vector<double> error(clusters.size(), -1);
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int)clusters.size(); i++)
 	{
-		string cluster = cl.first;
+		const string& cluster = clusters[i].first;
 
 		set<Point> points;
-		for (auto node : cl.second)
+		for (const Rectangle& rect : rects[i])
 		{
-			Rectangle rect = node->getBoundingRectangle();
 			points.insert(Point(rect.xl, rect.yl));
 			points.insert(Point(rect.xl, rect.yr));
 			points.insert(Point(rect.xr, rect.yl));
@@ -23,35 +41,41 @@ double computeContiguity(DotGraph& g)
 		
 		if ((int)points.size() <= 2) continue;
 
-		auto dt = DelaunayTriangulation::Create(vector<Point>(points.begin(), points.end()));
-		dt->InitializeIndex();
+		DelaunayMesh mesh(vector<Point>(points.begin(), points.end()));
+
+		vector<Point> queries;
+		for (int j = 0; j < (int)positions.size(); j++)
+			if (nodeClusters[j] != cluster)
+				queries.push_back(positions[j]);
+
+		VI faces;
+		mesh.locate(queries, faces);
 
 		// count misclassified nodes
 		int correct = 0;
 		int incorrect = 0;
-		for (auto node : g.nodes)
-			if (node->getCluster() != cluster)
+		for (int f : faces)
+			if (f == -1 || mesh.isGhost(f))
 			{
-				Point pos = node->getPos();
-				Triangle* triangle = dt->find(pos);
-				if (triangle->halfplane)
-				{
-					//outside
-					correct++;
-				}
-				else
-				{
-					//inside
-					incorrect++;
-				}
+				//outside
+				correct++;
+			}
+			else
+			{
+				//inside
+				incorrect++;
 			}
 
 		double er = double(incorrect) / double(correct + incorrect);
 		assert(0.0 <= er && er <= 1.0);
-		error.push_back(er);
+		error[i] = er;
 
 		//cerr << cluster << ": " << incorrect << " / " << correct << endl;
 	}
 
-	return 1.0 - Average(error);
+	vector<double> computed;
+	for (double er : error)
+		if (er >= 0) computed.push_back(er);
+
+	return 1.0 - Average(computed);
 }
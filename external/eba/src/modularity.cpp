@@ -4,7 +4,7 @@
 
 void Modularity::cluster(DotGraph& g)
 {
-	vector<vector<DotNode*> > clust = modularity::runModularity(g, contigous);
+	vector<vector<DotNode*> > clust = modularity::runModularity(g, contigous, parallel);
 	g.AssignClusters(clust, 0);
 }
 
@@ -17,11 +17,15 @@ public:
 	int n;
 	double totalWeight;
 
-	// edges with weights
-	vector<vector<int> > links;
-	vector<vector<double> > weights;
-	// spatial neighbors (contains adjacent nodes)
-	vector<set<int> > adj;
+	// edges with weights in the compressed row format:
+	// the edges of node i are links[linkBegin[i]], ..., links[linkBegin[i + 1] - 1]
+	vector<int> linkBegin;
+	vector<int> links;
+	vector<double> weights;
+	// spatial neighbors (contains adjacent nodes) in the same format, sorted for every node;
+	// adjBegin is empty without contiguity
+	vector<int> adjBegin;
+	vector<int> adj;
 
 	// weighted degree
 	vector<double> weightedDegree;
@@ -30,22 +34,51 @@ public:
 
 	BinaryGraph(int n, bool contiguity): n(n), totalWeight(0) 
 	{
-		links = vector<vector<int> >(n, vector<int>());
-		weights = vector<vector<double> >(n, vector<double>());
+		linkBegin = vector<int>(1, 0);
 		if (contiguity)
-			adj = vector<set<int> >(n, set<int>());
+			adjBegin = vector<int>(1, 0);
 
 		weightedDegree = vector<double>(n, 0);
 		selfLoops = vector<double>(n, 0);
 	}
 
+	bool hasAdj() const
+	{
+		return !adjBegin.empty();
+	}
+
+	// the edges of the next node (the nodes are added in the order of their indices)
+	void addNode(const vector<int>& nodeLinks, const vector<double>& nodeWeights, const vector<int>& nodeAdj)
+	{
+		assert(nodeLinks.size() == nodeWeights.size());
+
+		links.insert(links.end(), nodeLinks.begin(), nodeLinks.end());
+		weights.insert(weights.end(), nodeWeights.begin(), nodeWeights.end());
+		linkBegin.push_back((int)links.size());
+
+		if (hasAdj())
+		{
+			adj.insert(adj.end(), nodeAdj.begin(), nodeAdj.end());
+			adjBegin.push_back((int)adj.size());
+		}
+	}
+
 	void InitWeights()
 	{
+		assert((int)linkBegin.size() == n + 1);
+		assert(!hasAdj() || (int)adjBegin.size() == n + 1);
+
+		#pragma omp parallel for
 		for (int i = 0; i < n; i++)
 		{
 			weightedDegree[i] = getWeightedDegree(i);
 			selfLoops[i] = countSelfloops(i);
 		}
+
+		// each link is counted twice
+		totalWeight = 0;
+		for (int i = 0; i < (int)weights.size(); i++)
+			totalWeight += weights[i];
 	}
 
 private:
@@ -54,10 +87,10 @@ private:
 	{
 		assert (node >= 0 && node < n);
 
-		for (int i = 0; i < (int)links[node].size(); i++)
+		for (int i = linkBegin[node]; i < linkBegin[node + 1]; i++)
 		{
-			if (links[node][i] == node)
-				return weights[node][i];
+			if (links[i] == node)
+				return weights[i];
 		}
 		return 0;
 	}
@@ -68,8 +101,8 @@ private:
 		assert (node >= 0 && node < n);
 
 		double res = 0;
-		for (int i = 0; i < (int)weights[node].size(); i++)
-			res += weights[node][i];
+		for (int i = linkBegin[node]; i < linkBegin[node + 1]; i++)
+			res += weights[i];
 		return res;
 	}
 };
@@ -1,9 +1,15 @@
 #include "community.h"
 
+#include "profile/profile.h"
+
 #include <set>
 
 namespace modularity {
 
+// the best moves computed by the passes over the nodes; the ones computed again in the parallel mode
+static profile::Counter Moves("louvain_moves");
+static profile::Counter RecomputedMoves("louvain_recomputed_moves");
+
 double Community::modularity() const
 {
 	double q = 0.;
@@ -18,38 +24,187 @@ double Community::modularity() const
 	return q;
 }
 
-// computation of all neighboring communities of current node
-map<int, double> Community::neigh_comm(int node) const
+void Community::best_move(int node, Scratch& scratch, Move& move) const
 {
-	set<int> adj_comm;
+	scratch.stamp++;
+	int node_comm = n2c[node];
+
 	if (contiguity)
 	{
-		for (auto adj_neigh : g->adj[node])
+		for (int i = g->adjBegin[node]; i < g->adjBegin[node + 1]; i++)
 		{
+			int adj_neigh = g->adj[i];
 			if (adj_neigh == node) continue;
 
-			int neigh_comm = n2c[adj_neigh];
-			adj_comm.insert(neigh_comm);
+			scratch.adjacent[n2c[adj_neigh]] = scratch.stamp;
 		}
 	}
 
-	map<int, double> res;
-	int comm = n2c[node];
-	res[comm] = 0;
-	for (int i = 0; i < (int)g->links[node].size(); i++)
+	// computation of all neighboring communities of current node
+	vector<int>& ncomm = move.candidates;
+	ncomm.clear();
+	ncomm.push_back(node_comm);
+	scratch.listed[node_comm] = scratch.stamp;
+	scratch.weight[node_comm] = 0;
+	for (int i = g->linkBegin[node]; i < g->linkBegin[node + 1]; i++)
 	{
-		int neigh = g->links[node][i];
+		int neigh = g->links[i];
 		if (neigh == node) continue;
 
 		int neigh_comm = n2c[neigh];
-		if (contiguity && neigh_comm != comm && !adj_comm.count(neigh_comm)) continue;
+		if (contiguity && neigh_comm != node_comm && scratch.adjacent[neigh_comm] != scratch.stamp) continue;
+
+		if (scratch.listed[neigh_comm] != scratch.stamp)
+		{
+			scratch.listed[neigh_comm] = scratch.stamp;
+			scratch.weight[neigh_comm] = 0;
+			ncomm.push_back(neigh_comm);
+		}
+
+		scratch.weight[neigh_comm] += g->weights[i];
+	}
+
+	// the communities are tried in the order of their indices
+	sort(ncomm.begin(), ncomm.end());
+
+	// compute the nearest community for node
+	// default choice for future insertion is the former community
+	double degc = g->weightedDegree[node];
+	double m2 = g->totalWeight;
+	move.comm = node_comm;
+	move.dnodeOld = scratch.weight[node_comm];
+	move.dnodeNew = 0;
+	double best_increase = 0;
+	for (int new_comm : ncomm)
+	{
+		double totc = tot[new_comm];
+		if (new_comm == node_comm)
+			totc -= degc;
+
+		double increase = scratch.weight[new_comm] - totc * degc / m2;
+		if (increase > best_increase + 1e-8)
+		{
+			move.comm = new_comm;
+			move.dnodeNew = scratch.weight[new_comm];
+			best_increase = increase;
+		}
+	}
+}
+
+bool Community::move_nodes()
+{
+	Scratch scratch(g->n);
+	Move move;
+
+	bool improvement = false;
+	// for each node: remove the node from its community and insert it in the best community
+	for (int node = 0; node < g->n; node++)
+	{
+		int node_comm = n2c[node];
+		best_move(node, scratch, move);
+
+		remove(node, node_comm, move.dnodeOld);
+		insert(node, move.comm, move.dnodeNew);
 
-		double neigh_weight = g->weights[node][i];
-		res[neigh_comm] += neigh_weight;
+		if (move.comm != node_comm)
+			improvement = true;
 	}
 
+	Moves.add(g->n);
+	return improvement;
+}
+
+bool Community::move_nodes_parallel()
+{
+	// the nodes are processed in batches: the best moves of the nodes of a batch are computed in parallel
+	// for the state before the batch, and then they are applied in the order of the nodes. A move is
+	// computed again if a neighbor of the node has changed its community or the total of one of the
+	// candidate communities has changed since, so the result is the same as of move_nodes
+	const int BatchSize = 256;
+	vector<Move> moves(BatchSize);
+	// the last batch in which the node changed its community or the total of the community changed
+	vector<int> nodeChanged(g->n, -1);
+	vector<int> commChanged(g->n, -1);
+
+	bool improvement = false;
+	#pragma omp parallel
+	{
+		Scratch scratch(g->n);
+		for (int begin = 0; begin < g->n; begin += BatchSize)
+		{
+			int end = min(g->n, begin + BatchSize);
+
+			#pragma omp for schedule(dynamic, 8)
+			for (int node = begin; node < end; node++)
+				best_move(node, scratch, moves[node - begin]);
 
-	return res;
+			#pragma omp single
+			{
+				if (apply_moves(begin, end, moves, scratch, nodeChanged, commChanged))
+					improvement = true;
+			}
+		}
+	}
+
+	Moves.add(g->n);
+	return improvement;
+}
+
+bool Community::apply_moves(int begin, int end, vector<Move>& moves, Scratch& scratch, vector<int>& nodeChanged, vector<int>& commChanged)
+{
+	int batch = begin;
+	bool improvement = false;
+	int recomputed = 0;
+	for (int node = begin; node < end; node++)
+	{
+		Move& move = moves[node - begin];
+		if (!is_current(node, move, batch, nodeChanged, commChanged))
+		{
+			best_move(node, scratch, move);
+			recomputed++;
+		}
+
+		int node_comm = n2c[node];
+		double oldTot = tot[node_comm];
+		double newTot = tot[move.comm];
+
+		remove(node, node_comm, move.dnodeOld);
+		insert(node, move.comm, move.dnodeNew);
+
+		if (tot[node_comm] != oldTot)
+			commChanged[node_comm] = batch;
+		if (tot[move.comm] != newTot)
+			commChanged[move.comm] = batch;
+
+		if (move.comm != node_comm)
+		{
+			nodeChanged[node] = batch;
+			improvement = true;
+		}
+	}
+
+	RecomputedMoves.add(recomputed);
+	return improvement;
+}
+
+bool Community::is_current(int node, const Move& move, int batch, const vector<int>& nodeChanged, const vector<int>& commChanged) const
+{
+	for (int i = g->linkBegin[node]; i < g->linkBegin[node + 1]; i++)
+		if (nodeChanged[g->links[i]] == batch)
+			return false;
+
+	if (contiguity)
+	{
+		for (int i = g->adjBegin[node]; i < g->adjBegin[node + 1]; i++)
+			if (nodeChanged[g->adj[i]] == batch)
+				return false;
+	}
+
+	for (int comm : move.candidates)
+		if (commChanged[comm] == batch)
+			return false;
+
+	return true;
 }
 
 double Community::one_level()
@@ -67,43 +222,9 @@ double Community::one_level()
 	do
 	{
 		cur_mod = new_mod;
-		improvement = false;
 		nb_pass_done++;
 
-		// for each node: remove the node from its community and insert it in the best community
-		for (int node_tmp = 0; node_tmp < g->n; node_tmp++)
-		{
-			int node = node_tmp;
-			int node_comm = n2c[node];
-
-			// computation of all neighboring communities of current node
-			map<int, double> ncomm = neigh_comm(node);
-
-			// remove node from its current community
-			remove(node, node_comm, ncomm[node_comm]);
-
-			// compute the nearest community for node
-			// default choice for future insertion is the former community
-			int best_comm = node_comm;
-			double best_nblinks = 0;
-			double best_increase = 0;
-			for (auto iter = ncomm.begin(); iter != ncomm.end(); iter++)
-			{
-				int new_comm = (*iter).first;
-				double increase = gain_modularity(node, new_comm, ncomm[new_comm]);
-				if (increase > best_increase + 1e-8)
-				{
-					best_comm = new_comm;
-					best_nblinks = ncomm[new_comm];
-					best_increase = increase;
-				}
-			}
-
-			insert(node, best_comm, best_nblinks);
-
-			if (best_comm != node_comm)
-				improvement = true;
-		}
+		improvement = (parallel ? move_nodes_parallel() : move_nodes());
 
 		new_mod = modularity();
 		//cerr << "pass number " << nb_pass_done << " of " << nb_pass << " : " << new_mod << " " << cur_mod << endl;
@@ -115,60 +236,71 @@ double Community::one_level()
 
 BinaryGraph* Community::prepareBinaryGraph() const
 {
-	map<int, vector<int> > comm;
-	map<int, int> comm2Order;
+	// the communities are numbered in the order of their first nodes
+	vector<int> comm2Order(g->n, -1);
 	vector<int> order;
 	for (int i = 0; i < g->n; i++)
 	{
-		if (!comm.count(n2c[i]))
+		if (comm2Order[n2c[i]] == -1)
 		{
-			comm[n2c[i]] = vector<int>();
+			comm2Order[n2c[i]] = (int)order.size();
 			order.push_back(n2c[i]);
-			comm2Order[n2c[i]] = (int)order.size() - 1;
 		}
-
-		comm[n2c[i]].push_back(i);
 	}
 
-	// unweigthed to weighted
-	BinaryGraph* g2 = new BinaryGraph((int)order.size(), contiguity);
-	// initialize edges
-	for (int ci = 0; ci < (int)order.size(); ci++)
+	int n2 = (int)order.size();
+	vector<vector<int> > comm(n2);
+	for (int i = 0; i < g->n; i++)
+		comm[comm2Order[n2c[i]]].push_back(i);
+
+	// unweigthed to weighted: the edges of every community are collected in parallel
+	vector<vector<int> > links(n2);
+	vector<vector<double> > weights(n2);
+	vector<vector<int> > adj(n2);
+	#pragma omp parallel
 	{
-		int cIndex = order[ci];
-		map<int, double> m;
+		// m[c] is valid iff listed[c] == ci
+		vector<double> m(n2, 0);
+		vector<int> listed(n2, -1);
 
-		for (int i = 0; i < (int)comm[cIndex].size(); i++)
+		#pragma omp for schedule(dynamic, 16)
+		for (int ci = 0; ci < n2; ci++)
 		{
-			int vIndex = comm[cIndex][i];
-			for (int i = 0; i < (int)g->links[vIndex].size(); i++)
+			for (int vIndex : comm[ci])
 			{
-				int neigh = g->links[vIndex][i];
-				int neigh_comm = comm2Order[n2c[neigh]];
-				double neigh_weight = g->weights[vIndex][i];
-
-				m[neigh_comm] += neigh_weight;
-			}
+				for (int i = g->linkBegin[vIndex]; i < g->linkBegin[vIndex + 1]; i++)
+				{
+					int neigh_comm = comm2Order[n2c[g->links[i]]];
+					if (listed[neigh_comm] != ci)
+					{
+						listed[neigh_comm] = ci;
+						m[neigh_comm] = 0;
+						links[ci].push_back(neigh_comm);
+					}
+
+					m[neigh_comm] += g->weights[i];
+				}
 
-			if (contiguity)
-			{
-				for (auto adj_neigh : g->adj[vIndex])
+				if (contiguity)
 				{
-					int neigh_comm = comm2Order[n2c[adj_neigh]];
-					g2->adj[ci].insert(neigh_comm);
+					for (int i = g->adjBegin[vIndex]; i < g->adjBegin[vIndex + 1]; i++)
+						adj[ci].push_back(comm2Order[n2c[g->adj[i]]]);
 				}
 			}
-		}
 
-		for (auto it : m)
-		{
-			int neigh_comm = it.first;
-			g2->totalWeight += m[neigh_comm];
-			g2->links[ci].push_back(neigh_comm);
-			g2->weights[ci].push_back(m[neigh_comm]);
+			sort(links[ci].begin(), links[ci].end());
+			for (int neigh_comm : links[ci])
+				weights[ci].push_back(m[neigh_comm]);
+
+			sort(adj[ci].begin(), adj[ci].end());
+			adj[ci].erase(unique(adj[ci].begin(), adj[ci].end()), adj[ci].end());
 		}
 	}
 
+	BinaryGraph* g2 = new BinaryGraph(n2, contiguity);
+	for (int ci = 0; ci < n2; ci++)
+		g2->addNode(links[ci], weights[ci], adj[ci]);
+
 	g2->InitWeights();
 
 	return g2;
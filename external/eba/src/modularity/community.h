@@ -14,8 +14,33 @@ namespace modularity {
 class Community
 {
 private:
+	// the best community for a node: the weights of its edges to the current and to the new community,
+	// and the neighboring communities whose totals were used
+	struct Move
+	{
+		int comm;
+		double dnodeOld;
+		double dnodeNew;
+		vector<int> candidates;
+	};
+
+	// per-thread buffers for the neighboring communities of a node
+	struct Scratch
+	{
+		vector<double> weight;
+		// weight[c] is valid iff listed[c] == stamp
+		vector<int> listed;
+		// the communities of the spatial neighbors are marked with stamp
+		vector<int> adjacent;
+		int stamp;
+
+		Scratch(int n): weight(n, 0), listed(n, 0), adjacent(n, 0), stamp(0) {}
+	};
+
 	BinaryGraph* g;
 	bool contiguity;
+	// whether the nodes are moved in parallel batches
+	bool parallel;
 	vector<int> n2c;
 	vector<double> in;
 	vector<double> tot;
@@ -25,7 +50,7 @@ private:
 	Community& operator = (const Community&);
 
 public:
-	Community(BinaryGraph* g, bool contiguity) : g(g), contiguity(contiguity)
+	Community(BinaryGraph* g, bool contiguity, bool parallel = false) : g(g), contiguity(contiguity), parallel(parallel)
 	{
 		n2c = vector<int>(g->n);
 		in = vector<double>(g->n);
@@ -64,28 +89,28 @@ public:
 		n2c[node] = -1;
 	}
 
-	double gain_modularity(int node, int comm, double dnodecomm)
-	{
-		assert (node >= 0 && node < g->n);
-
-		double totc = tot[comm];
-		double degc = g->weightedDegree[node];
-		double m2 = g->totalWeight;
-		double dnc = dnodecomm;
-
-		return (dnc - totc * degc / m2);
-	}
-
 	double modularity() const;
 
-	// computation of all neighboring communities of current node
-	map<int, double> neigh_comm(int node) const;
-
 	double one_level();
 
 	BinaryGraph* prepareBinaryGraph() const;
 
 	Cluster* prepareCluster(const Cluster* rootCluster) const;
+
+private:
+	// the community maximizing the gain of modularity for the node, as if it were removed from its community
+	void best_move(int node, Scratch& scratch, Move& move) const;
+
+	// one pass over the nodes; returns true iff a node changed its community
+	bool move_nodes();
+	bool move_nodes_parallel();
+
+	// applies the moves of the nodes begin..end-1 computed at the start of the batch (the first node
+	// of a batch identifies it in nodeChanged and commChanged); returns true iff a node changed its community
+	bool apply_moves(int begin, int end, vector<Move>& moves, Scratch& scratch, vector<int>& nodeChanged, vector<int>& commChanged);
+
+	// whether the move computed at the start of the batch is still the best one
+	bool is_current(int node, const Move& move, int batch, const vector<int>& nodeChanged, const vector<int>& commChanged) const;
 };
 
 } // namespace modularity
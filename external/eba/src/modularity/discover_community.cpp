@@ -7,6 +7,7 @@
 #include "common/geometry/delaunay_triangulation.h"
 
 #include <iostream>
+#include <algorithm>
 
 namespace modularity {
 
@@ -34,11 +35,11 @@ void postProcessClusters(Cluster* cluster)
 	}
 }
 
-Cluster* BuildHierarchy(BinaryGraph* binaryGraph, Cluster* rootCluster, bool contiguity)
+Cluster* BuildHierarchy(BinaryGraph* binaryGraph, Cluster* rootCluster, bool contiguity, bool parallel)
 {
 	while (true)
 	{
-		Community c(binaryGraph, contiguity);
+		Community c(binaryGraph, contiguity, parallel);
 
 		double curModularity = c.modularity();
 		double newModularity = c.one_level();
@@ -62,27 +63,33 @@ BinaryGraph* CreateBinaryGraph(DotGraph& g, bool contiguity)
 	// initialize modularity graph
 	BinaryGraph* g2 = new BinaryGraph((int)g.nodes.size(), contiguity);
 	// initialize links: each link is counted twice
+	vector<int> links;
+	vector<double> weights;
+	vector<int> adj;
 	for (int i = 0; i < g2->n; i++)
 	{
 		DotNode* v = g.nodes[i];
-		vector<int> adj = g.adjE[v->index];
-		for (int j = 0; j < (int)adj.size(); j++)
+		links.clear();
+		weights.clear();
+		for (int j = 0; j < (int)g.adjE[v->index].size(); j++)
 		{
 			int nodeIndex = g.adj[v->index][j];
 			int edgeIndex = g.adjE[v->index][j];
 			DotEdge* edge = g.edges[edgeIndex];
-			double weight = edge->getWeight();
 
-			g2->links[i].push_back(nodeIndex);
-			g2->weights[i].push_back(weight);
-			g2->totalWeight += weight;
+			links.push_back(nodeIndex);
+			weights.push_back(edge->getWeight());
 		}
 
+		adj.clear();
 		if (contiguity)
 		{
 			for (DotNode* u : neighbors[v])
-				g2->adj[i].insert(u->index);
+				adj.push_back(u->index);
+			sort(adj.begin(), adj.end());
 		}
+
+		g2->addNode(links, weights, adj);
 	}
 
 	g2->InitWeights();
@@ -90,7 +97,7 @@ BinaryGraph* CreateBinaryGraph(DotGraph& g, bool contiguity)
 	return g2;
 }
 
-vector<vector<DotNode*> > runModularity(DotGraph& g, bool contiguity)
+vector<vector<DotNode*> > runModularity(DotGraph& g, bool contiguity, bool parallel)
 {
 	// initialize clusters
 	Cluster* rootCluster = new Cluster();
@@ -98,7 +105,7 @@ vector<vector<DotNode*> > runModularity(DotGraph& g, bool contiguity)
 		rootCluster->addVertex(i);
 
 	// run modularity
-	rootCluster = BuildHierarchy(CreateBinaryGraph(g, contiguity), rootCluster, contiguity);
+	rootCluster = BuildHierarchy(CreateBinaryGraph(g, contiguity), rootCluster, contiguity, parallel);
 
 	vector<vector<DotNode*> > res;
 	if (rootCluster->containsVertices())
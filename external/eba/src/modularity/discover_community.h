@@ -4,6 +4,7 @@
 
 namespace modularity {
 
-vector<vector<DotNode*> > runModularity(DotGraph& g, bool contiguity);
+// Louvain method; with parallel, the best moves of the nodes are computed in parallel (with the same result)
+vector<vector<DotNode*> > runModularity(DotGraph& g, bool contiguity, bool parallel = false);
 
 } // namespace modularity
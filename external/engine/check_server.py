@@ -0,0 +1,205 @@
+#!/usr/bin/python
+"""Checks the server mode of the engine: the jobs sent over stdin/stdout and over a Unix socket
+(one by one and at the same time) give the same results as the pipeline of the separate tools,
+also for a graph with over a million distinct attribute names, and the requests that are too long, garbled or fail validation are rejected without stopping
+the server. Usage: check_server.py [graph.gv] (a graph is generated, if none is supplied)"""
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+EXTERNAL = os.path.dirname(HERE)
+ENGINE = os.path.join(HERE, 'engine')
+KMEANS = os.path.join(EXTERNAL, 'eba', 'kmeans')
+MAPSETS = os.path.join(EXTERNAL, 'mapsets', 'mapsets')
+POINTCLOUD = os.path.join(EXTERNAL, 'pointcloud', 'pointcloud')
+GEN_GRAPH = os.path.join(EXTERNAL, 'bench', 'gen_graph')
+
+# the jobs and the commands of the separate tools with the same result
+JOBS = [
+	('-stages=clustering,mapsets -C=geometrickmeans', [[KMEANS, '-action=clustering', '-C=geometrickmeans'], [MAPSETS]]),
+	('-stages=mapsets,pointcloud', [[MAPSETS], [POINTCLOUD]]),
+]
+
+# the requests failing validation, with a graph (None for the input graph) and the error message
+INVALID = [
+	('-stages=clustering -C=graphkmeans -K=0', None, b"the value of '-K' is not a positive number"),
+	('-stages=mapsets', b'graph {\n  "a" [pos="0,0"];\n}\n', b"No attribute 'cluster' for the node 'a'"),
+	('-stages=metrics', b'graph {\n  "a" [pos="0,0", cluster="1"];\n  "a" -- "b";\n}\n', None),
+	('-stages=clustering,metrics,mapsets', None, b'stage "metrics" has to be the last one'),
+]
+
+failures = []
+
+def check(condition, message):
+	if not condition:
+		failures.append(message)
+		print('FAILED: ' + message)
+
+def pipeline(commands, graph):
+	data = graph
+	for command in commands:
+		proc = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+		data = proc.communicate(data)[0]
+		if proc.returncode != 0:
+			raise Exception('%s failed' % command[0])
+	return data
+
+def many_keys_graph(keys):
+	"""a graph whose nodes have ten attributes each, all of them with distinct names"""
+	lines = [b'graph {']
+	for i in range(keys // 10):
+		names = b', '.join(b'k%d="%d"' % (i * 10 + j, j) for j in range(10))
+		lines.append(b'  "n%d" [%s, clustercolor="#ff0000", pos="%d,%d"];' % (i, names, i % 300, i // 300))
+	lines.append(b'}\n')
+	return b'\n'.join(lines)
+
+def request(job_id, options, graph):
+	return ('%s %d %s\n' % (job_id, len(graph), options)).encode() + graph
+
+class Responses:
+	"""reads the responses of a stream: '<id> ok|error <length>' and the payload"""
+
+	def __init__(self, read):
+		self.read = read
+		self.buffer = b''
+
+	def take(self, count):
+		while len(self.buffer) < count:
+			chunk = self.read()
+			if not chunk:
+				return None
+			self.buffer += chunk
+		data, self.buffer = self.buffer[:count], self.buffer[count:]
+		return data
+
+	def next(self):
+		while b'\n' not in self.buffer:
+			chunk = self.read()
+			if not chunk:
+				return None
+			self.buffer += chunk
+		line, self.buffer = self.buffer.split(b'\n', 1)
+		job_id, status, length = line.decode().split()
+		return job_id, status, self.take(int(length))
+
+	def all(self):
+		result = {}
+		while True:
+			response = self.next()
+			if response is None:
+				return result
+			result[response[0]] = response[1:]
+
+def check_results(mode, responses, expected):
+	for job_id, output in expected.items():
+		check(job_id in responses, '%s: no response to job %s' % (mode, job_id))
+		if job_id in responses:
+			status, payload = responses[job_id]
+			check(status == 'ok', '%s: job %s failed: %s' % (mode, job_id, payload))
+			check(status != 'ok' or payload == output, '%s: job %s differs from the pipeline' % (mode, job_id))
+
+def check_rejected(mode, responses):
+	for i, (options, data, message) in enumerate(INVALID):
+		status, payload = responses.get('invalid%d' % i, ('', b''))
+		check(status == 'error', '%s: invalid job %d is not rejected' % (mode, i))
+		check(message is None or payload == b'job failed: ' + message, '%s: invalid job %d is rejected with \'%s\'' % (mode, i, payload.decode()))
+
+def run_stdio(threads, data):
+	proc = subprocess.Popen([ENGINE, '-serve=stdio', '-threads=%d' % threads], stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+	out = proc.communicate(data)[0]
+	chunks = [out]
+	return Responses(lambda: chunks.pop() if chunks else b'').all(), proc.returncode
+
+def connect(path):
+	client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+	client.connect(path)
+	return client
+
+def exchange(path, data):
+	client = connect(path)
+	client.sendall(data)
+	client.shutdown(socket.SHUT_WR)
+	responses = Responses(lambda: client.recv(1 << 16)).all()
+	client.close()
+	return responses
+
+def main():
+	if len(sys.argv) > 1:
+		with open(sys.argv[1], 'rb') as f:
+			graph = f.read()
+	else:
+		graph = subprocess.check_output([GEN_GRAPH, '-nodes=200', '-clusters=4'])
+
+	expected = {}
+	batch = b''
+	for i, (options, commands) in enumerate(JOBS):
+		job_id = 'job%d' % i
+		expected[job_id] = pipeline(commands, graph)
+		batch += request(job_id, options, graph)
+
+	# the invalid jobs come first, so that the valid ones run after them on the same stream
+	rejected = b''
+	for i, (options, data, message) in enumerate(INVALID):
+		rejected += request('invalid%d' % i, options, graph if data is None else data)
+
+	# stdio: one job at a time and all at the same time
+	for threads in [1, len(JOBS)]:
+		mode = 'stdio, %d thread(s)' % threads
+		responses, code = run_stdio(threads, rejected + batch)
+		check(code == 0, '%s: the engine exited with code %d' % (mode, code))
+		check_results(mode, responses, expected)
+		check_rejected(mode, responses)
+
+	# stdio: more distinct attribute names than any table of keys would hold, before the other jobs
+	keys = many_keys_graph(1100000)
+	responses, code = run_stdio(1, request('keys', '-stages=pointcloud', keys) + batch)
+	check(code == 0, 'stdio: the engine exited with code %d on many attribute names' % code)
+	check_results('stdio, many attribute names', responses, dict(expected, keys=pipeline([[POINTCLOUD]], keys)))
+
+	# stdio: an input over the limit is rejected and closes the stream
+	responses, code = run_stdio(1, b'big %d\n' % (1 << 31) + batch)
+	check(responses.get('big', ('',))[0] == 'error', 'stdio: an input over the limit is not rejected')
+	check(code == 0, 'stdio: the engine exited with code %d after an input over the limit' % code)
+
+	# socket: the same jobs over two connections at the same time, and garbled requests
+	path = os.path.join(tempfile.mkdtemp(), 'engine.sock')
+	server = subprocess.Popen([ENGINE, '-serve=socket', '-socket=' + path, '-threads=%d' % len(JOBS)], stderr=subprocess.PIPE)
+	try:
+		for attempt in range(100):
+			if os.path.exists(path):
+				break
+			time.sleep(0.1)
+		check(os.path.exists(path) and (os.stat(path).st_mode & 0o777) == 0o600, 'socket: the socket is not private to the user')
+
+		clients = [connect(path) for i in range(2)]
+		for client in clients:
+			client.sendall(rejected + batch)
+			client.shutdown(socket.SHUT_WR)
+		for client in clients:
+			responses = Responses(lambda: client.recv(1 << 16)).all()
+			check_results('socket', responses, expected)
+			check_rejected('socket', responses)
+			client.close()
+
+		check(exchange(path, b'not a request\n') == {}, 'socket: a garbled request is answered')
+		check(exchange(path, b'big %d\n' % (1 << 31)).get('big', ('',))[0] == 'error', 'socket: an input over the limit is not rejected')
+		check(server.poll() is None, 'socket: the server stopped after the rejected requests')
+		check_results('socket, after the rejected requests', exchange(path, batch), expected)
+	finally:
+		server.kill()
+		server.wait()
+		if os.path.exists(path):
+			os.unlink(path)
+		os.rmdir(os.path.dirname(path))
+
+	if failures:
+		print('%d check(s) failed' % len(failures))
+		sys.exit(1)
+	print('-- All server checks passed --')
+
+if __name__ == '__main__':
+	main()
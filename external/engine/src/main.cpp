@@ -0,0 +1,104 @@
+#include "common/common.h"
+#include "common/random_utils.h"
+#include "common/cmd_options.h"
+
+#include "profile/profile.h"
+
+#include "stages.h"
+#include "server.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+void PrepareCMDOptions(int argc, char** argv, CMDOptions& args)
+{
+	string msg;
+	msg += "Usage: engine [options] input_file\n";
+	msg += "When input_file is not supplied, the program reads from stdin.\n";
+	msg += "In the server mode, the job options given here are the defaults for all the jobs.\n";
+	args.SetUsageMessage(msg);
+
+	args.AddAllowedOption("", "", "Input file name (stdin, if no input file is supplied)");
+	args.AddAllowedOption("-o", "", "Output file name (stdout, if no output file is supplied)");
+
+	args.AddAllowedOption("-serve", "none", "Whether to run a single job or to serve many jobs sent over stdin/stdout or a Unix socket");
+	args.AddAllowedValue("-serve", "none");
+	args.AddAllowedValue("-serve", "stdio");
+	args.AddAllowedValue("-serve", "socket");
+	args.AddAllowedOption("-socket", "/tmp/gmap-engine.sock", "Path of the socket for '-serve=socket'");
+	args.AddAllowedOption("-threads", "0", "The number of jobs run at the same time in the server mode (the number of cores, if 0); the cores are split between them");
+	args.AddAllowedOption("--profile", "Write the wall time, the peak memory and the event counters of every stage to stderr as JSON (ignored in the server mode)");
+
+	engine::AddJobOptions(args);
+
+	args.Parse(argc, argv);
+}
+
+//the job options of the command line
+VS DefaultJobOptions(int argc, char** argv)
+{
+	VS result;
+	for (int i = 1; i < argc; i++)
+	{
+		string s(argv[i]);
+		string name = s.substr(0, s.find('='));
+		if (name.empty() || name[0] != '-') continue;
+		if (name == "-o" || name == "-serve" || name == "-socket" || name == "-threads" || name == "--profile") continue;
+
+		result.push_back(s);
+	}
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	InitRand(123);
+
+	auto options = CMDOptions::Create();
+
+	int returnCode = 0;
+	try
+	{
+		PrepareCMDOptions(argc, argv, *options);
+
+		string mode = options->getOption("-serve");
+		if (mode == "none")
+		{
+			if (options->hasOption("--profile"))
+				profile::Enable();
+
+			shared_ptr<dotio::DotBuffer> input = dotio::DotBuffer::Load(options->getOption(""));
+			dotio::DotStreamWriter writer(options->getOption("-o"));
+			engine::RunJob(*options, input, writer);
+		}
+		else
+		{
+			engine::Server server(toInt(options->getOption("-threads")), DefaultJobOptions(argc, argv));
+			if (mode == "stdio")
+			{
+				//stdout carries the responses
+				cout.rdbuf(cerr.rdbuf());
+				server.ServeStream(STDIN_FILENO, STDOUT_FILENO);
+			}
+			else
+			{
+				server.ServeSocket(options->getOption("-socket"));
+			}
+		}
+	}
+	catch (int code)
+	{
+		returnCode = code;
+	}
+	catch (std::exception& e)
+	{
+		cout << e.what() << "\n";
+		returnCode = 1;
+	}
+
+	profile::Report("engine", argc, argv);
+	return returnCode;
+}
@@ -0,0 +1,12 @@
+#include "stages.h"
+
+#include "mapsets.h"
+
+namespace engine {
+
+void BuildMapSets(DotGraph& g, bool fullVisibility, bool parallelAdjustment, bool logAdjustment)
+{
+	mapsets::BuildTrees(g, fullVisibility, parallelAdjustment, logAdjustment);
+}
+
+} // namespace engine
@@ -0,0 +1,336 @@
+#include "server.h"
+#include "stages.h"
+
+#include <iostream>
+#include <sstream>
+#include <set>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace engine {
+
+//the largest input of a job (in bytes); a request with a longer one is rejected
+const long long MaxInputLength = (long long)1 << 30;
+//the longest request line; the connection is closed after a longer one
+const size_t MaxLineLength = 1 << 16;
+
+//both ends of a client; the descriptors are closed with the last reference
+class Connection
+{
+	Connection(const Connection&);
+	Connection& operator = (const Connection&);
+
+	int in, out;
+	bool ownsDescriptors;
+	std::mutex writeMutex;
+
+	vector<char> buffer;
+	size_t begin, end;
+
+public:
+	Connection(int in, int out, bool ownsDescriptors): in(in), out(out), ownsDescriptors(ownsDescriptors), buffer(1 << 16), begin(0), end(0) {}
+
+	~Connection()
+	{
+		if (ownsDescriptors)
+		{
+			close(in);
+			if (out != in) close(out);
+		}
+	}
+
+	//returns false at the end of the input or after MaxLineLength bytes without a line break
+	bool ReadLine(string& line)
+	{
+		line.clear();
+		while (true)
+		{
+			if (line.length() > MaxLineLength)
+			{
+				cerr << "request line is too long\n";
+				return false;
+			}
+			if (begin == end && !Fill()) return !line.empty();
+
+			char* p = &buffer[begin];
+			char* q = (char*)memchr(p, '\n', end - begin);
+			if (q != NULL)
+			{
+				line.append(p, q);
+				begin += (q - p) + 1;
+				return true;
+			}
+
+			line.append(p, end - begin);
+			begin = end;
+		}
+	}
+
+	bool ReadBytes(size_t length, vector<char>& text)
+	{
+		text.resize(length);
+		size_t done = 0;
+		while (done < length)
+		{
+			if (begin == end && !Fill()) return false;
+
+			size_t cnt = min(length - done, end - begin);
+			memcpy(&text[done], &buffer[begin], cnt);
+			begin += cnt;
+			done += cnt;
+		}
+		return true;
+	}
+
+	void Send(const string& id, bool ok, const string& payload)
+	{
+		ostringstream header;
+		header << id << (ok ? " ok " : " error ") << payload.length() << "\n";
+
+		std::lock_guard<std::mutex> lock(writeMutex);
+		WriteAll(header.str());
+		WriteAll(payload);
+	}
+
+private:
+	bool Fill()
+	{
+		begin = end = 0;
+		while (true)
+		{
+			ssize_t cnt = read(in, &buffer[0], buffer.size());
+			if (cnt < 0 && errno == EINTR) continue;
+			if (cnt <= 0) return false;
+			end = cnt;
+			return true;
+		}
+	}
+
+	void WriteAll(const string& s)
+	{
+		size_t done = 0;
+		while (done < s.length())
+		{
+			ssize_t cnt = write(out, s.data() + done, s.length() - done);
+			if (cnt < 0 && errno == EINTR) continue;
+			//the client is gone
+			if (cnt <= 0) return;
+			done += cnt;
+		}
+	}
+};
+
+Server::Server(int threads, const VS& defaultOptions): defaultOptions(defaultOptions), stopping(false)
+{
+	int cores = max(1, (int)std::thread::hardware_concurrency());
+	if (threads <= 0)
+		threads = cores;
+
+	//the cores are split between the jobs run at the same time
+	threadsPerJob = max(1, cores / threads);
+
+	for (int i = 0; i < threads; i++)
+		workers.push_back(std::thread(&Server::WorkerLoop, this));
+}
+
+Server::~Server()
+{
+	Stop();
+}
+
+void Server::ServeStream(int in, int out)
+{
+	Serve(shared_ptr<Connection>(new Connection(in, out, false)));
+	Stop();
+}
+
+void Server::ServeSocket(const string& path)
+{
+	//writing to a closed connection should not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.length() >= sizeof(addr.sun_path))
+	{
+		cerr << "socket path '" << path << "' is too long\n";
+		throw 1;
+	}
+	strcpy(addr.sun_path, path.c_str());
+
+	//a stale socket of the same user is replaced; anything else at the path is kept
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode) || st.st_uid != getuid())
+		{
+			cerr << "'" << path << "' exists and is not a socket of the user\n";
+			throw 1;
+		}
+		unlink(path.c_str());
+	}
+
+	//only the user can connect: the socket is created without the permissions of the others
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	mode_t oldMask = umask(0077);
+	bool bound = (fd != -1 && bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+	umask(oldMask);
+	if (!bound || chmod(path.c_str(), 0600) != 0 || listen(fd, 16) != 0)
+	{
+		cerr << "can't listen on socket '" << path << "': " << strerror(errno) << "\n";
+		throw 1;
+	}
+
+	while (true)
+	{
+		int client = accept(fd, NULL, NULL);
+		if (client == -1)
+		{
+			if (errno != EINTR)
+				cerr << "can't accept a connection: " << strerror(errno) << "\n";
+			continue;
+		}
+
+		shared_ptr<Connection> connection(new Connection(client, client, true));
+		std::thread(&Server::Serve, this, connection).detach();
+	}
+}
+
+void Server::Serve(const shared_ptr<Connection>& connection)
+{
+	string line;
+	while (connection->ReadLine(line))
+	{
+		if (line.empty()) continue;
+
+		Job job;
+		job.connection = connection;
+
+		istringstream header(line);
+		long long length = -1;
+		header >> job.id >> length;
+		if (header.fail() || length < 0)
+		{
+			cerr << "malformed request '" << line << "'\n";
+			return;
+		}
+
+		//the rest of the stream can't be trusted, so the connection is closed
+		if (length > MaxInputLength)
+		{
+			cerr << "input of job '" << job.id << "' is too long (" << length << " bytes)\n";
+			connection->Send(job.id, false, "input is longer than " + to_string(MaxInputLength) + " bytes");
+			return;
+		}
+
+		string option;
+		while (header >> option)
+			job.options.push_back(option);
+
+		try
+		{
+			if (!connection->ReadBytes((size_t)length, job.input))
+			{
+				cerr << "incomplete input of job '" << job.id << "'\n";
+				return;
+			}
+		}
+		catch (std::bad_alloc&)
+		{
+			cerr << "no memory for the input of job '" << job.id << "'\n";
+			connection->Send(job.id, false, "no memory for the input");
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push(Job());
+		swap(jobs.back(), job);
+		jobAdded.notify_one();
+	}
+}
+
+void Server::WorkerLoop()
+{
+#ifdef _OPENMP
+	//the parallel regions of the stages started by this thread
+	omp_set_num_threads(threadsPerJob);
+#endif
+
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (jobs.empty() && !stopping)
+				jobAdded.wait(lock);
+
+			if (jobs.empty()) return;
+			swap(job, jobs.front());
+			jobs.pop();
+		}
+
+		RunJob(job);
+	}
+}
+
+void Server::RunJob(Job& job)
+{
+	string output;
+	try
+	{
+		auto options = CMDOptions::Create();
+		AddJobOptions(*options);
+
+		//the server defaults first, except the ones given in the job (an option keeps the first
+		//value that differs from its default, so a job could not set a default value back)
+		set<string> jobNames;
+		for (int i = 0; i < (int)job.options.size(); i++)
+			jobNames.insert(job.options[i].substr(0, job.options[i].find('=')));
+		for (int i = 0; i < (int)defaultOptions.size(); i++)
+			if (!jobNames.count(defaultOptions[i].substr(0, defaultOptions[i].find('='))))
+				options->SetOption(defaultOptions[i]);
+		for (int i = 0; i < (int)job.options.size(); i++)
+			options->SetOption(job.options[i]);
+
+		dotio::DotStreamWriter writer(&output);
+		engine::RunJob(*options, dotio::DotBuffer::Take(job.input), writer);
+	}
+	catch (int code)
+	{
+		job.connection->Send(job.id, false, "job failed with code " + to_string(code));
+		return;
+	}
+	catch (std::exception& e)
+	{
+		job.connection->Send(job.id, false, string("job failed: ") + e.what());
+		return;
+	}
+
+	job.connection->Send(job.id, true, output);
+}
+
+void Server::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		jobAdded.notify_all();
+	}
+
+	for (int i = 0; i < (int)workers.size(); i++)
+		if (workers[i].joinable())
+			workers[i].join();
+}
+
+} // namespace engine
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common/common.h"
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <queue>
+
+namespace engine {
+
+class Connection;
+
+//Runs jobs received over streams on a pool of worker threads
+//
+//A request is a line '<id> <length> [job options]' followed by <length> bytes of the input graph;
+//the response is a line '<id> ok <length>' followed by the output, or '<id> error <length>' followed
+//by a message. Responses are sent in the order of completion. The options missing in a request
+//are taken from defaultOptions. Every job runs its parallel stages on cores / threads cores
+class Server
+{
+	Server(const Server&);
+	Server& operator = (const Server&);
+
+	struct Job
+	{
+		shared_ptr<Connection> connection;
+		string id;
+		VS options;
+		vector<char> input;
+	};
+
+	VS defaultOptions;
+	int threadsPerJob;
+
+	std::mutex mutex;
+	std::condition_variable jobAdded;
+	std::queue<Job> jobs;
+	bool stopping;
+	vector<std::thread> workers;
+
+public:
+	Server(int threads, const VS& defaultOptions);
+	~Server();
+
+	//serves requests from the input until it is closed; waits for all the jobs
+	void ServeStream(int in, int out);
+	//serves connections to a Unix socket; never returns
+	void ServeSocket(const string& path);
+
+private:
+	void Serve(const shared_ptr<Connection>& connection);
+	void WorkerLoop();
+	void RunJob(Job& job);
+	void Stop();
+};
+
+} // namespace engine
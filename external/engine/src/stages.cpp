@@ -0,0 +1,331 @@
+#include "stages.h"
+
+#include "common/common.h"
+#include "common/random_utils.h"
+#include "common/graph/dot_parser.h"
+
+#include "profile/profile.h"
+
+#include "clustering.h"
+#include "metrics.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <cctype>
+
+namespace engine {
+
+void AddJobOptions(CMDOptions& args)
+{
+	args.AddAllowedOption("-stages", "clustering", "Comma-separated list of stages applied to the graph in the given order: clustering, mapsets, pointcloud and metrics (only as the last one)");
+
+	args.AddAllowedOption("-C", "Type of clustering");
+	args.AddAllowedValue("-C", "geometrickmeans");
+	args.AddAllowedValue("-C", "graphkmeans");
+	args.AddAllowedValue("-C", "geometrichierarchical");
+	args.AddAllowedValue("-C", "graphhierarchical");
+	args.AddAllowedValue("-C", "infomap");
+	args.AddAllowedValue("-C", "modularity");
+	args.AddAllowedValue("-C", "modularity-cont");
+
+	args.AddAllowedOption("-K", "", "Desired number of clusters (selected automatically, if no value is supplied)");
+
+	args.AddAllowedOption("-louvain", "serial", "Local moving of modularity clustering: move the nodes one by one or compute their moves in parallel batches (with the same result)");
+	args.AddAllowedValue("-louvain", "serial");
+	args.AddAllowedValue("-louvain", "parallel");
+
+	args.AddAllowedOption("-metrics", "exact", "Algorithms for computing layout metrics; 'large' is not limited in the size of the graph");
+	args.AddAllowedValue("-metrics", "exact");
+	args.AddAllowedValue("-metrics", "large");
+	args.AddAllowedOption("-samples", "0", "The number of sampled nodes for estimating pairwise metrics in the 'large' mode (all nodes, if 0)");
+
+	args.AddAllowedOption("-memory", "1024", "Memory limit (in MB) for caching graph-theoretic distances");
+	args.AddAllowedOption("-distances", "exact", "Whether graph-theoretic distances may be approximated when all of them do not fit into the memory limit");
+	args.AddAllowedValue("-distances", "exact");
+	args.AddAllowedValue("-distances", "approximate");
+
+	args.AddAllowedOption("-visibility", "sparse", "Visibility graph for the trees of mapsets: the closest points only or all visible pairs");
+	args.AddAllowedValue("-visibility", "sparse");
+	args.AddAllowedValue("-visibility", "full");
+
+	args.AddAllowedOption("-adjustment", "serial", "Force-directed adjustment of the trees of mapsets: move the nodes one by one or at the same time (in parallel)");
+	args.AddAllowedValue("-adjustment", "serial");
+	args.AddAllowedValue("-adjustment", "parallel");
+
+	args.AddAllowedOption("-log", "none", "Print the energy and the time of every iteration of the adjustment of mapsets to stderr");
+	args.AddAllowedValue("-log", "none");
+	args.AddAllowedValue("-log", "adjustment");
+}
+
+namespace {
+
+//the message of a rejected job is the error response of the server
+void Reject(const string& message)
+{
+	throw runtime_error(message);
+}
+
+VS ParseStages(const string& list)
+{
+	VS stages = SplitNotNull(list, ",");
+	if (stages.empty())
+	{
+		Reject("no stages are specified");
+	}
+
+	for (int i = 0; i < (int)stages.size(); i++)
+	{
+		const string& s = stages[i];
+		if (s != "clustering" && s != "metrics" && s != "mapsets" && s != "pointcloud")
+		{
+			Reject("unknown stage \"" + s + "\"");
+		}
+
+		if (s == "metrics" && i + 1 != (int)stages.size())
+		{
+			Reject("stage \"metrics\" has to be the last one");
+		}
+	}
+
+	return stages;
+}
+
+bool IsNumber(const string& s)
+{
+	if (s.empty() || s.length() > 9) return false;
+	for (int i = 0; i < (int)s.length(); i++)
+		if (!isdigit((unsigned char)s[i])) return false;
+	return true;
+}
+
+//rejects the options and the graphs that would fail an assertion of the stage (and stop the
+//server with it); the tools don't check them, since they stop anyway
+void ValidateStage(const CMDOptions& options, const string& stage, DotGraph& g)
+{
+	if (g.nodes.empty())
+		Reject("the graph has no nodes");
+
+	if (stage == "clustering" || stage == "metrics")
+	{
+		if (!IsNumber(options.getOption("-memory")))
+			Reject("the value of '-memory' is not a number");
+
+		for (int i = 0; i < (int)g.edges.size(); i++)
+			if (!(g.edges[i]->getLen() > 0))
+				Reject("the edge '" + g.edges[i]->s + "' -- '" + g.edges[i]->t + "' has a non-positive length");
+	}
+
+	string K = (stage == "clustering" ? options.getOption("-K") : "");
+	if (K != "" && K != "graph" && (!IsNumber(K) || toInt(K) < 1))
+		Reject("the value of '-K' is not a positive number");
+	if (stage == "metrics" && !IsNumber(options.getOption("-samples")))
+		Reject("the value of '-samples' is not a number");
+
+	//pointcloud checks its own attributes
+	if (stage == "pointcloud") return;
+
+	bool needCluster = (stage == "mapsets" || stage == "metrics" || K == "graph");
+	for (int i = 0; i < (int)g.nodes.size(); i++)
+	{
+		DotNode* v = g.nodes[i];
+		if (!v->attr.has(dotio::KEY_POS))
+			Reject("No attribute 'pos' for the node '" + v->id + "'");
+		if (needCluster && !v->attr.has(dotio::KEY_CLUSTER))
+			Reject("No attribute 'cluster' for the node '" + v->id + "'");
+		if (stage == "mapsets" && (!v->attr.has(dotio::KEY_WIDTH) || !v->attr.has(dotio::KEY_HEIGHT)))
+			Reject("No attribute 'width' or 'height' for the node '" + v->id + "'");
+	}
+
+	//the scaling of the stress needs a pair of connected nodes at different positions
+	if (stage == "metrics" && !g.edges.empty())
+	{
+		bool spread = false;
+		for (int i = 0; i < (int)g.edges.size() && !spread; i++)
+		{
+			Point s = g.findNodeById(g.edges[i]->s)->getPos();
+			Point t = g.findNodeById(g.edges[i]->t)->getPos();
+			spread = (s.Distance(t) > EPS);
+		}
+
+		if (!spread)
+			Reject("the endpoints of all edges are at the same positions");
+	}
+}
+
+void PrepareDistances(const CMDOptions& options, DotGraph& g)
+{
+	size_t memoryBudget = (size_t)toInt(options.getOption("-memory")) * 1024 * 1024;
+	bool approximate = (options.getOption("-distances") == "approximate");
+	g.setDistanceBudget(memoryBudget, approximate);
+}
+
+//a fresh graph over the entries of g, as if g was written and read again by the next tool;
+//mapsets reads its input dropping consecutive duplicate edges
+DotGraph Reload(DotGraph& g, bool dropDuplicateEdges)
+{
+	DotGraph h;
+	h.buffer = g.buffer;
+	h.style = g.style;
+
+	for (int i = 0; i < (int)g.nodes.size(); i++)
+	{
+		DotNode* v = g.nodes[i];
+		v->index = (int)h.nodes.size();
+		v->pos = Point(-1.0, -1.0);
+		h.nodes.push_back(v);
+	}
+
+	for (int i = 0; i < (int)g.edges.size(); i++)
+	{
+		DotEdge* e = g.edges[i];
+		if (dropDuplicateEdges && !h.edges.empty() && h.edges.back()->s == e->s && h.edges.back()->t == e->t)
+		{
+			delete e;
+			continue;
+		}
+
+		e->index = (int)h.edges.size();
+		e->len = -1;
+		h.edges.push_back(e);
+	}
+
+	h.initAdjacencyList();
+	return h;
+}
+
+void FreeGraph(DotGraph& g)
+{
+	for (int i = 0; i < (int)g.style.size(); i++)
+		delete g.style[i];
+	for (int i = 0; i < (int)g.nodes.size(); i++)
+		delete g.nodes[i];
+	for (int i = 0; i < (int)g.edges.size(); i++)
+		delete g.edges[i];
+
+	g.style.clear();
+	g.nodes.clear();
+	g.edges.clear();
+}
+
+//filled nodes of the cluster colors over a map without the background (as pointcloud)
+void PointCloud(DotGraph& g)
+{
+	//remove background
+	for (int i = 0; i < (int)g.style.size(); i++)
+	{
+		if (g.style[i]->id == "graph")
+		{
+			g.style[i]->removeAttr("_background");
+			g.style[i]->removeAttr("bb");
+			g.style[i]->removeAttr("bgcolor");
+			break;
+		}
+	}
+
+	//remove shape
+	//set style to fillcolor
+	for (int i = 0; i < (int)g.style.size(); i++)
+	{
+		if (g.style[i]->id == "node")
+		{
+			g.style[i]->removeAttr("shape");
+			g.style[i]->setAttr("style", "filled");
+			break;
+		}
+	}
+
+	//add fillcolor
+	for (int i = 0; i < (int)g.nodes.size(); i++)
+	{
+		if (!g.nodes[i]->hasAttr("clustercolor"))
+		{
+			Reject("No attribute 'clustercolor' for the node '" + g.nodes[i]->id + "'");
+		}
+
+		g.nodes[i]->setAttr("fillcolor", g.nodes[i]->getClusterColor());
+	}
+}
+
+void RunStage(const CMDOptions& options, const string& stage, DotGraph& g, dotio::DotStreamWriter& output)
+{
+	if (stage == "clustering")
+	{
+		PrepareDistances(options, g);
+		ClusterGraph(g, options.getOption("-C"), options.getOption("-K"), options.getOption("-louvain") == "parallel");
+	}
+	else if (stage == "mapsets")
+	{
+		BuildMapSets(g, 
+			options.getOption("-visibility") == "full", 
+			options.getOption("-adjustment") == "parallel", 
+			options.getOption("-log") == "adjustment");
+	}
+	else if (stage == "pointcloud")
+	{
+		PointCloud(g);
+	}
+	else if (stage == "metrics")
+	{
+		PrepareDistances(options, g);
+
+		Metrics m;
+		m.largeGraph = (options.getOption("-metrics") == "large");
+		m.samples = toInt(options.getOption("-samples"));
+		m.Compute(g);
+
+		ostringstream report;
+		m.OutputLayout(report);
+		m.OutputCluster(report);
+		output.Write(report.str());
+	}
+}
+
+} // namespace
+
+void RunJob(const CMDOptions& options, const shared_ptr<dotio::DotBuffer>& input, dotio::DotStreamWriter& output)
+{
+	VS stages = ParseStages(options.getOption("-stages"));
+	//fail before reading the graph, if the algorithm is not specified
+	if (count(stages.begin(), stages.end(), "clustering"))
+		options.getOption("-C");
+
+	DotGraph g;
+	{
+		profile::Stage stage("read");
+		DotReader parser(stages[0] == "mapsets");
+		g = parser.ReadGraph(input);
+	}
+
+	try
+	{
+		for (int i = 0; i < (int)stages.size(); i++)
+		{
+			//every stage starts as a separate tool would
+			InitRand(123);
+			profile::Stage stage(stages[i]);
+			if (i > 0)
+				g = Reload(g, stages[i] == "mapsets");
+
+			ValidateStage(options, stages[i], g);
+			RunStage(options, stages[i], g, output);
+		}
+
+		profile::Stage stage("write");
+		if (stages.back() != "metrics")
+		{
+			//pointcloud omits empty attribute lists of the styles
+			DotWriter writer(stages.back() != "pointcloud");
+			writer.WriteGraph(output, g);
+		}
+		output.Flush();
+	}
+	catch (...)
+	{
+		FreeGraph(g);
+		throw;
+	}
+
+	FreeGraph(g);
+}
+
+} // namespace engine
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common/cmd_options.h"
+#include "common/graph/dot_graph.h"
+
+#include "dotio/dot_reader.h"
+#include "dotio/dot_writer.h"
+
+#include <memory>
+
+namespace engine {
+
+//options of a single job: the list of stages and the options of kmeans
+void AddJobOptions(CMDOptions& args);
+
+//runs the stages of the job on the graph of the input and writes the result (a graph or,
+//if the last stage is 'metrics', a report); throws 1 if the job cannot be completed
+void RunJob(const CMDOptions& options, const shared_ptr<dotio::DotBuffer>& input, dotio::DotStreamWriter& output);
+
+//mapsets::BuildTrees; compiled against the sources of mapsets
+void BuildMapSets(DotGraph& g, bool fullVisibility, bool parallelAdjustment, bool logAdjustment);
+
+} // namespace engine
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common/common.h"
+#include "common/geometry/rectangle.h"
+
+#include <unordered_map>
+#include <cassert>
+
+//Uniform grid over items given by their bounding boxes
+//
+//An item is registered in every cell overlapped by its box; an item is moved by removing it
+//with the old box and inserting it with the new one. A query reports the items registered in
+//the cells overlapped by a rectangle (an item can be reported several times)
+class BoxGrid
+{
+	BoxGrid(const BoxGrid&);
+	BoxGrid& operator = (const BoxGrid&);
+
+	double cellSize;
+	unordered_map<long long, VI> cells;
+
+public:
+	BoxGrid(double cellSize): cellSize(cellSize)
+	{
+		assert(cellSize > 0);
+	}
+
+	void insert(int item, const Rectangle& box)
+	{
+		ForEachCell(box, [&](long long cell) { cells[cell].push_back(item); });
+	}
+
+	void remove(int item, const Rectangle& box)
+	{
+		ForEachCell(box, [&](long long cell)
+		{
+			auto it = cells.find(cell);
+			assert(it != cells.end());
+
+			VI& items = it->second;
+			for (int i = 0; i < (int)items.size(); i++)
+				if (items[i] == item)
+				{
+					items[i] = items.back();
+					items.pop_back();
+					break;
+				}
+		});
+	}
+
+	template <class F>
+	void query(const Rectangle& range, F f) const
+	{
+		ForEachCell(range, [&](long long cell)
+		{
+			auto it = cells.find(cell);
+			if (it == cells.end()) return;
+
+			const VI& items = it->second;
+			for (int i = 0; i < (int)items.size(); i++)
+				f(items[i]);
+		});
+	}
+
+private:
+	long long CellCoord(double x) const
+	{
+		return (long long)floor(x / cellSize);
+	}
+
+	template <class F>
+	void ForEachCell(const Rectangle& box, F f) const
+	{
+		long long cx1 = CellCoord(box.xr);
+		long long cy1 = CellCoord(box.yr);
+		for (long long cx = CellCoord(box.xl); cx <= cx1; cx++)
+			for (long long cy = CellCoord(box.yl); cy <= cy1; cy++)
+				f((long long)(((unsigned long long)cx << 32) ^ (unsigned long long)(unsigned int)cy));
+	}
+};
@@ -7,15 +7,20 @@
 
 class CEST2Approx: public CESTAlgorithm
 {
+	bool fullVisibility;
+
 public:
+	CEST2Approx(bool fullVisibility = false): fullVisibility(fullVisibility) {}
+
 	map<string, SegmentSet*> BuildTrees(DotGraph& g)
 	{
 		//DrawSpanningTrees(g);
 
 		VS clusterOrder = GetClusterOrder(g);
 
-		//find optimal spanning tree for each cluster
-		vector<Segment> obstacles;
+		//find optimal spanning tree for each cluster; the trees stay in the index
+		//and the boundaries of the nodes are replaced for every cluster
+		ObstacleIndex obstacles(ObstacleIndex::SuggestedCellSize(GetBoundaryObstacles(g, "", 1.0)));
 		map<string, SegmentSet*> trees;
 
 		double marginDelta = 0.05;
@@ -25,17 +30,18 @@ public:
 			string clusterId = clusterOrder[k];
 
 			//get obstacles
-			vector<Segment> allObstacles = obstacles;
-			vector<Segment> boundaryObstacles = GetBoundaryObstacles(g, clusterId, marginCoef);
-			allObstacles.insert(allObstacles.end(), boundaryObstacles.begin(), boundaryObstacles.end());
+			int treeObstacles = obstacles.count();
+			obstacles.append(GetBoundaryObstacles(g, clusterId, marginCoef));
 
 			vector<Point> positions = g.GetClusterPositions(clusterId);
-			SegmentSet* tree = BuildSpanningTree(positions, allObstacles, false);
-			//CheckTreeConnected(tree, positions, allObstacles);
+			SegmentSet* tree = BuildSpanningTree(positions, obstacles, fullVisibility);
+			//CheckTreeConnected(tree, positions, obstacles.getSegments());
+
+			obstacles.truncate(treeObstacles);
 
 			trees[clusterId] = tree;
 			for (int i = 0; i < tree->count(); i++)
-				obstacles.push_back(tree->get(i));
+				obstacles.append(tree->get(i));
 
 			marginCoef -= marginDelta;
 		}
@@ -109,6 +115,14 @@ private:
 	}
 
 	SegmentSet* BuildSpanningTree(const vector<Point>& points, const vector<Segment>& obstacles, bool fullVisibility)
+	{
+		ObstacleIndex index(ObstacleIndex::SuggestedCellSize(obstacles));
+		index.append(obstacles);
+
+		return BuildSpanningTree(points, index, fullVisibility);
+	}
+
+	SegmentSet* BuildSpanningTree(const vector<Point>& points, const ObstacleIndex& obstacles, bool fullVisibility)
 	{
 		VisibilityGraph visGraph(points, obstacles, fullVisibility);
 		//OutputTimeInfo("vis DotGraph constructed");
@@ -203,4 +217,4 @@ private:
 	{
 		return p1.Distance(p2);
 	}
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "fd_adjustment.h"
 
+#include "profile/profile.h"
+
+#include <chrono>
+
 const double RoutingNode::IdealRadius = 105.0;
 const double RoutingNode::IdealHubWidth = 105.0;
 const double CostCalculator::InkImportance = 0.01;
@@ -11,8 +15,11 @@ const double MaxStep = 50;
 const double MinStep = 1;
 const double MinRelativeChange = 0.0005;
 
-int stepsWithProgress = 0;
-double UpdateMaxStep(double step, double oldEnergy, double newEnergy) 
+//the iterations of the adjustment and the moves of the nodes made by them
+static profile::Counter Iterations("adjustment_iterations");
+static profile::Counter Moves("adjustment_moves");
+
+double UpdateMaxStep(double step, double oldEnergy, double newEnergy, int& stepsWithProgress) 
 {
     //cooling factor
     double T = 0.8;
@@ -51,7 +58,7 @@ bool Converged(double step, vector<Point>& oldx, vector<Point>& newx)
 Point BuildForceForInk(RoutingGraph& vg, RoutingNode* node) 
 {
     Point direction = Point();
-	vector<RoutingNode*> neighbors = node->Neighbors();
+	const vector<RoutingNode*>& neighbors = node->Neighbors();
 	for (int i = 0; i < (int)neighbors.size(); i++)
 	{
 		RoutingNode* adj = neighbors[i];
@@ -97,7 +104,7 @@ Point BuildForceForRadius(RoutingGraph& vg, RoutingNode* node)
 Point BuildForceForBundle(RoutingGraph& vg, RoutingNode* node)
 {
     Point direction = Point();
-	vector<RoutingNode*> neigbors = node->Neighbors();
+	const vector<RoutingNode*>& neigbors = node->Neighbors();
 	for (int i = 0; i < (int)neigbors.size(); i++)
 	{
 		RoutingNode* adj = neigbors[i];
@@ -140,31 +147,44 @@ Point BuildDirection(RoutingGraph& vg, RoutingNode* node)
     return force;
 }
 
+/// Costs of a node at its current position, which stays the same while the moves are evaluated
+struct NodeCost
+{
+	double radius;
+	double bundle;
+
+	NodeCost(RoutingGraph& vg, RoutingNode* node)
+	{
+		radius = CostCalculator::RadiusCost(vg, node, node->Position());
+		bundle = CostCalculator::BundleCost(vg, node);
+	}
+};
+
 /// Computes cost delta when moving the node
 /// the cost will be negative if a new position overlaps obstacles
-double CostGain(RoutingGraph& vg, RoutingNode* node, Point newPosition) 
+double CostGain(RoutingGraph& vg, RoutingNode* node, const NodeCost& cost, Point newPosition) 
 {
     double MInf = -12345678.0;
-    double rGain = CostCalculator::RadiusGain(vg, node, newPosition);
+    double rGain = CostCalculator::RadiusGain(vg, node, cost.radius, newPosition);
     if (rGain < MInf) return MInf;
-    double bundleGain = CostCalculator::BundleGain(vg, node, newPosition);
+    double bundleGain = CostCalculator::BundleGain(vg, node, cost.bundle, newPosition);
     if (bundleGain < MInf) return MInf;
     double inkGain = CostCalculator::InkGain(vg, node, newPosition);
 
     return rGain + inkGain + bundleGain;
 }
 
-double BuildStepLength(RoutingGraph& vg, RoutingNode* node, Point direction, double maxStep) 
+double BuildStepLength(RoutingGraph& vg, RoutingNode* node, const NodeCost& cost, Point direction, double maxStep) 
 {
     double stepLength = MinStep;
 
-    double costGain = CostGain(vg, node, node->Position() + direction * stepLength);
+    double costGain = CostGain(vg, node, cost, node->Position() + direction * stepLength);
     if (costGain < 0.01)
         return 0;
 
     while (2 * stepLength <= MaxStep) 
 	{
-        double newCostGain = CostGain(vg, node, node->Position() + direction * stepLength * 2);
+        double newCostGain = CostGain(vg, node, cost, node->Position() + direction * stepLength * 2);
         if (newCostGain <= costGain)
             break;
 
@@ -175,40 +195,100 @@ double BuildStepLength(RoutingGraph& vg, RoutingNode* node, Point direction, dou
     return stepLength;
 }
 
-/// Move node to decrease the cost of the drawing
-/// Returns true iff position has changed
-bool TryMoveNode(RoutingGraph& vg, RoutingNode* node, double maxStep) 
+/// Finds a step to decrease the cost of the drawing (zero if the node should stay)
+template <class RandomDirection>
+Point FindStep(RoutingGraph& vg, RoutingNode* node, double maxStep, RandomDirection randomDirection) 
 {
     Point direction = BuildDirection(vg, node);
-    if (direction.Length() < EPS) return false;
+    if (direction.Length() < EPS) return Point();
 
-    double stepLength = BuildStepLength(vg, node, direction, maxStep);
+    NodeCost cost(vg, node);
+    double stepLength = BuildStepLength(vg, node, cost, direction, maxStep);
     if (stepLength < MinStep) 
 	{
         //try random direction
-        direction = Point::RandomPoint();
-        stepLength = BuildStepLength(vg, node, direction, maxStep);
+        direction = randomDirection();
+        stepLength = BuildStepLength(vg, node, cost, direction, maxStep);
         if (stepLength < MinStep)
-            return false;
+            return Point();
     }
 
-    Point step = direction * stepLength;
+    return direction * stepLength;
+}
+
+/// The energy of the drawing (as CostCalculator::Cost) updated with the cost deltas of the moves:
+/// a move changes the ink and the hub costs of the moved node and of the nodes of the other trees near its segments
+class RunningEnergy
+{
+	RoutingGraph& vg;
+	//by the indices of the nodes
+	VD radiusCost;
+	double radius;
+	vector<RoutingNode*> hubs;
+
+public:
+	RunningEnergy(RoutingGraph& vg): vg(vg), radius(0)
+	{
+		vector<RoutingNode*> vNodes = vg.VirtualNodes();
+		for (int i = 0; i < (int)vNodes.size(); i++)
+		{
+			int index = vNodes[i]->Index();
+			if (index >= (int)radiusCost.size())
+				radiusCost.resize(index + 1, 0);
+
+			radiusCost[index] = CostCalculator::RadiusCost(vg, vNodes[i], vNodes[i]->Position());
+			radius += radiusCost[index];
+		}
+	}
+
+	double Value() const
+	{
+		return CostCalculator::InkImportance * vg.Ink() + radius;
+	}
+
+	void MoveNode(RoutingNode* node, const Point& newPosition)
+	{
+		hubs.clear();
+		vg.HubsNearNode(node, hubs);
+		vg.MoveNode(node, newPosition);
+		vg.HubsNearNode(node, hubs);
+
+		sort(hubs.begin(), hubs.end(), [](RoutingNode* a, RoutingNode* b) { return a->Index() < b->Index(); });
+		hubs.erase(unique(hubs.begin(), hubs.end()), hubs.end());
+		for (int i = 0; i < (int)hubs.size(); i++)
+		{
+			double cost = CostCalculator::RadiusCost(vg, hubs[i], hubs[i]->Position());
+			radius += cost - radiusCost[hubs[i]->Index()];
+			radiusCost[hubs[i]->Index()] = cost;
+		}
+	}
+};
+
+/// Move node to decrease the cost of the drawing
+/// Returns true iff position has changed
+bool TryMoveNode(RoutingGraph& vg, RunningEnergy& energy, RoutingNode* node, double maxStep) 
+{
+    Point step = FindStep(vg, node, maxStep, []() { return Point::RandomPoint(); });
+    if (step.Length() < EPS) return false;
+
     Point newPosition = node->Position() + step;
     //can this happen?
     //if (vg.PointToStations.ContainsKey(newPosition)) return false;
 
-    vg.MoveNode(node, newPosition);
+    energy.MoveNode(node, newPosition);
+    Moves.add();
     return true;
 }
 
-bool TryMoveNodes(RoutingGraph& vg, double step) 
+/// Gauss-Seidel iteration: the nodes are moved one by one
+bool TryMoveNodes(RoutingGraph& vg, RunningEnergy& energy, double step) 
 {
     bool coordinatesChanged = false;
 	vector<RoutingNode*> vNodes = vg.VirtualNodes();
 	for (int i = 0; i < (int)vNodes.size(); i++)
 	{
 		RoutingNode* node = vNodes[i];
-        if (TryMoveNode(vg, node, step)) 
+        if (TryMoveNode(vg, energy, node, step)) 
 		{
             coordinatesChanged = true;
         }
@@ -217,23 +297,70 @@ bool TryMoveNodes(RoutingGraph& vg, double step)
     return coordinatesChanged;
 }
 
-void ForceDirectedAdjustment(const DotGraph& g, map<string, SegmentSet*>& trees)
+/// Jacobi iteration: the steps of all nodes are found for the same drawing in parallel and
+/// then applied one by one, unless a step is no longer improving (after the moves of the nearby nodes)
+bool TryMoveNodesParallel(RoutingGraph& vg, RunningEnergy& energy, double step) 
+{
+	vector<RoutingNode*> vNodes = vg.VirtualNodes();
+
+	//drawn in advance, so that the result does not depend on the number of threads
+	vector<Point> randomDirections(vNodes.size());
+	for (int i = 0; i < (int)vNodes.size(); i++)
+		randomDirections[i] = Point::RandomPoint();
+
+	vector<Point> steps(vNodes.size());
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int)vNodes.size(); i++)
+	{
+		steps[i] = FindStep(vg, vNodes[i], step, [&]() { return randomDirections[i]; });
+	}
+
+    bool coordinatesChanged = false;
+	for (int i = 0; i < (int)vNodes.size(); i++)
+	{
+		RoutingNode* node = vNodes[i];
+		if (steps[i].Length() < EPS) continue;
+
+		Point newPosition = node->Position() + steps[i];
+		if (CostGain(vg, node, NodeCost(vg, node), newPosition) < 0.01) continue;
+
+		energy.MoveNode(node, newPosition);
+		Moves.add();
+		coordinatesChanged = true;
+    }
+
+    return coordinatesChanged;
+}
+
+void ForceDirectedAdjustment(const DotGraph& g, map<string, SegmentSet*>& trees, bool parallel, bool log)
 {
 	double step = MaxStep;
 	double energy = INF;
+	int stepsWithProgress = 0;
+
+	auto startTime = chrono::steady_clock::now();
 
-	RoutingGraph vg = RoutingGraph(g, trees);
+	RoutingGraph vg(g, trees);
+	RunningEnergy runningEnergy(vg);
 	vector<Point> x = vg.VirtualNodesPositions();
 	int iteration = 0;
 	while (iteration++ < MaxIterations) 
 	{
-		bool coordinatesChanged = TryMoveNodes(vg, step);
+		Iterations.add();
+		bool coordinatesChanged = (parallel ? TryMoveNodesParallel(vg, runningEnergy, step) : TryMoveNodes(vg, runningEnergy, step));
 		if (!coordinatesChanged) break;
 
 		double oldEnergy = energy;
-		energy = CostCalculator::Cost(vg);
+		energy = runningEnergy.Value();
 
-		step = UpdateMaxStep(step, oldEnergy, energy);
+		if (log)
+		{
+			//the cost of the whole drawing checks the drift of the running energy
+			double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+			fprintf(stderr, "adjustment iteration %3d: energy = %.3lf (full cost %.3lf)  step = %.3lf  time = %.3lfs\n", iteration, energy, CostCalculator::Cost(vg), step, elapsed);
+		}
+
+		step = UpdateMaxStep(step, oldEnergy, energy, stepsWithProgress);
 		vector<Point> oldX = x;
 		x = vg.VirtualNodesPositions();
 		if (step < MinStep || Converged(step, oldX, x)) break;
@@ -241,4 +368,3 @@ void ForceDirectedAdjustment(const DotGraph& g, map<string, SegmentSet*>& trees)
 
 	vg.UpdateTrees(trees);
 }
-
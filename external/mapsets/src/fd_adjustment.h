@@ -6,8 +6,13 @@
 #include "common/graph/dot_graph.h"
 
 #include "segment_set.h"
+#include "box_grid.h"
 
-void ForceDirectedAdjustment(const DotGraph& g, map<string, SegmentSet*>& trees);
+#include <algorithm>
+
+//parallel: the nodes are moved at the same time (Jacobi-style) on all cores instead of one by one;
+//log: the energy and the time of every iteration are printed to stderr
+void ForceDirectedAdjustment(const DotGraph& g, map<string, SegmentSet*>& trees, bool parallel = false, bool log = false);
 
 class RoutingGraph;
 
@@ -19,12 +24,13 @@ class RoutingNode
 	bool isVirtual;
 	vector<RoutingNode*> neighbors;
 	Point position;
+	int index;
 
 public:
     static const double IdealRadius;
     static const double IdealHubWidth;
 
-	RoutingNode(const string& cluster, const Point& position): cluster(cluster), position(position)
+	RoutingNode(const string& cluster, const Point& position, int index): cluster(cluster), position(position), index(index)
 	{
 		isVirtual = true;
 	}
@@ -34,7 +40,12 @@ public:
 		return position;
 	}
 
-	inline vector<RoutingNode*> Neighbors()
+	inline int Index() const
+	{
+		return index;
+	}
+
+	inline const vector<RoutingNode*>& Neighbors() const
 	{
 		return neighbors;
 	}
@@ -42,13 +53,24 @@ public:
 
 class RoutingGraph
 {
+	RoutingGraph(const RoutingGraph&);
+	RoutingGraph& operator = (const RoutingGraph&);
+
 	double ink;
 	vector<RoutingNode*> nodes;
 
 	vector<Rectangle> hardObstacles;
 
+	//the segments of the trees, from every node to every its neighbor (in the order of nodes),
+	//and the node boundaries are kept in grids; the segments are updated as the nodes move
+	vector<pair<RoutingNode*, RoutingNode*> > treeEdges;
+	vector<Rectangle> treeEdgeBoxes;
+	VVI nodeTreeEdges;
+	BoxGrid treeEdgeGrid;
+	BoxGrid obstacleGrid;
+
 public:
-	RoutingGraph(const DotGraph& g, const map<string, SegmentSet*>& trees)
+	RoutingGraph(const DotGraph& g, const map<string, SegmentSet*>& trees): treeEdgeGrid(RoutingNode::IdealRadius), obstacleGrid(RoutingNode::IdealRadius)
 	{
 		//cut long tree segments
 		for (auto iter = trees.begin(); iter != trees.end(); iter++)
@@ -118,6 +140,8 @@ public:
 			realNode->isVirtual = false;
 			//realNode->cluster = "";
 		}
+
+		BuildIndex();
 	}
 
 	RoutingNode* findOrCreateNode(const Point& pos, const string& cluster)
@@ -125,7 +149,7 @@ public:
 		RoutingNode* node = findNode(pos, cluster);
 		if (node != NULL) return node;
 
-		node = new RoutingNode(cluster, pos);
+		node = new RoutingNode(cluster, pos, (int)nodes.size());
 		nodes.push_back(node);
 		return node;
 	}
@@ -171,6 +195,16 @@ public:
         }
 
 		node->position = newPosition;
+
+		//update the index
+		const VI& edges = nodeTreeEdges[node->index];
+		for (int i = 0; i < (int)edges.size(); i++)
+		{
+			int e = edges[i];
+			treeEdgeGrid.remove(e, treeEdgeBoxes[e]);
+			treeEdgeBoxes[e] = TreeEdgeBox(e);
+			treeEdgeGrid.insert(e, treeEdgeBoxes[e]);
+		}
 	}
 
 	inline double Ink() const
@@ -178,6 +212,26 @@ public:
 		return ink;
 	}
 
+	//the virtual nodes whose hub costs depend on the position of the node: the node itself and the
+	//nodes of the other trees within the ideal radius of its segments (possibly repeated)
+	void HubsNearNode(RoutingNode* node, vector<RoutingNode*>& hubs) const
+	{
+		hubs.push_back(node);
+
+		const VI& edges = nodeTreeEdges[node->index];
+		for (int i = 0; i < (int)edges.size(); i++)
+		{
+			Rectangle range = BoundingBox(treeEdges[edges[i]].first->position, treeEdges[edges[i]].second->position, RoutingNode::IdealRadius);
+			//every node is the first end of its own segments
+			treeEdgeGrid.query(range, [&](int e)
+			{
+				RoutingNode* hub = treeEdges[e].first;
+				if (hub->isVirtual && hub->cluster != node->cluster && range.Contains(hub->position))
+					hubs.push_back(hub);
+			});
+		}
+	}
+
 	void UpdateTrees(map<string, SegmentSet*>& trees)
 	{
 		//remove old
@@ -220,15 +274,19 @@ public:
 		}
 	}
 
-	bool HubAvoidsObstacles(RoutingNode* node, const Point& nodePosition, double idealR, vector<Point>& touchedObstacles)
+	bool HubAvoidsObstacles(RoutingNode* node, const Point& nodePosition, double idealR, vector<Point>& touchedObstacles) const
 	{
+		Rectangle range = BoundingBox(nodePosition, nodePosition, idealR);
+
 		set<Point> res;
 		//node boundaries
-		for (int i = 0; i < (int)hardObstacles.size(); i++)
+		VI nearObstacles = NearObstacles(range);
+		for (int k = 0; k < (int)nearObstacles.size(); k++)
 		{
-			if (hardObstacles[i].Contains(nodePosition)) return false;
+			const Rectangle& obstacle = hardObstacles[nearObstacles[k]];
+			if (obstacle.Contains(nodePosition)) return false;
 
-			Point closestP = geometry::ClosestPoint(hardObstacles[i], nodePosition);
+			Point closestP = geometry::ClosestPoint(obstacle, nodePosition);
 			if (closestP.Distance(nodePosition) >= idealR) continue;
 			if (res.find(closestP) != res.end()) continue;
 
@@ -236,66 +294,107 @@ public:
 			touchedObstacles.push_back(closestP);
 		}
 
-		//other trees
-		map<string, Point> clusterToClosest;
-		for (int i = 0; i < (int)nodes.size(); i++)
+		//other trees: a point of the last segment (in the order of nodes) within the radius
+		map<string, int> clusterToLast;
+		treeEdgeGrid.query(range, [&](int e)
 		{
-			if (nodes[i]->cluster == node->cluster) continue;
-
-			double curMinDist = INF;
-			if (clusterToClosest.find(node->cluster) != clusterToClosest.end())
-				curMinDist = clusterToClosest[node->cluster].Distance(nodePosition);
+			const string& cluster = treeEdges[e].first->cluster;
+			if (cluster == node->cluster) return;
 
-			for (int j = 0; j < (int)nodes[i]->neighbors.size(); j++)
-			{
-				Segment seg2 = Segment(nodes[i]->position, nodes[i]->neighbors[j]->position);
-				Point closestP = geometry::ClosestPoint(seg2, nodePosition);
-				double dist = closestP.Distance(nodePosition);
-				if (dist >= idealR) continue;
-				if (dist >= curMinDist) continue;
+			auto it = clusterToLast.find(cluster);
+			if (it != clusterToLast.end() && (*it).second >= e) return;
+			if (ClosestPoint(e, nodePosition).Distance(nodePosition) >= idealR) return;
 
-				clusterToClosest[nodes[i]->cluster] = closestP;
-			}
-		}
+			clusterToLast[cluster] = e;
+		});
 
-		for (auto iter = clusterToClosest.begin(); iter != clusterToClosest.end(); iter++)
+		for (auto iter = clusterToLast.begin(); iter != clusterToLast.end(); iter++)
 		{
 			assert((*iter).first != node->cluster);
-			touchedObstacles.push_back((*iter).second);
+			touchedObstacles.push_back(ClosestPoint((*iter).second, nodePosition));
 		}
 
 		return true;
 	}
 
 	bool BundleAvoidsObstacles(RoutingNode* node, RoutingNode* adj, const Point& nodePosition, const Point& adjPosition, 
-		double idealDist, vector<pair<Point, Point> >& touchedObstacles)
+		double idealDist, vector<pair<Point, Point> >& touchedObstacles) const
 	{
+		assert(node->isVirtual);
+
 		//node boundaries
-		for (int i = 0; i < (int)hardObstacles.size(); i++)
+		VI nearObstacles = NearObstacles(BoundingBox(nodePosition, adjPosition, idealDist));
+		for (int k = 0; k < (int)nearObstacles.size(); k++)
 		{
-			assert(node->isVirtual);
-			if (!adj->isVirtual && hardObstacles[i].Contains(adjPosition)) continue;
+			const Rectangle& obstacle = hardObstacles[nearObstacles[k]];
+			if (!adj->isVirtual && obstacle.Contains(adjPosition)) continue;
 
 			Point p1, p2;
-			if (geometry::Intersect(hardObstacles[i], Segment(nodePosition, adjPosition), p1, p2)) return false;
+			if (geometry::Intersect(obstacle, Segment(nodePosition, adjPosition), p1, p2)) return false;
 			if ((p1 - p2).Length() >= idealDist) continue;
 			touchedObstacles.push_back(make_pair(p1, p2));
 		}
 
 		//other trees
-		for (int i = 0; i < (int)nodes.size(); i++)
+		Segment seg(nodePosition, adjPosition);
+		bool intersects = false;
+		treeEdgeGrid.query(BoundingBox(nodePosition, adjPosition, 0), [&](int e)
 		{
-			if (nodes[i]->cluster == node->cluster) continue;
+			if (intersects || treeEdges[e].first->cluster == node->cluster) return;
 
-			Segment seg(nodePosition, adjPosition);
+			Segment seg2 = Segment(treeEdges[e].first->position, treeEdges[e].second->position);
+			if (Segment::EdgesIntersect(seg, seg2)) intersects = true;
+		});
+
+		return !intersects;
+	}
+
+private:
+	void BuildIndex()
+	{
+		for (int i = 0; i < (int)hardObstacles.size(); i++)
+			obstacleGrid.insert(i, hardObstacles[i]);
+
+		nodeTreeEdges = VVI(nodes.size(), VI());
+		for (int i = 0; i < (int)nodes.size(); i++)
 			for (int j = 0; j < (int)nodes[i]->neighbors.size(); j++)
 			{
-				Segment seg2 = Segment(nodes[i]->position, nodes[i]->neighbors[j]->position);
-				if (Segment::EdgesIntersect(seg, seg2)) return false;
+				int e = (int)treeEdges.size();
+				treeEdges.push_back(make_pair(nodes[i], nodes[i]->neighbors[j]));
+				treeEdgeBoxes.push_back(TreeEdgeBox(e));
+				treeEdgeGrid.insert(e, treeEdgeBoxes[e]);
+
+				nodeTreeEdges[i].push_back(e);
+				nodeTreeEdges[nodes[i]->neighbors[j]->index].push_back(e);
 			}
-		}
+	}
 
-		return true;
+	//the box of segment pq extended by the distance (and the tolerance of the intersection tests)
+	static Rectangle BoundingBox(const Point& p, const Point& q, double dist)
+	{
+		double d = dist + 1e-6 * (p.Distance(q) + dist + 1.0);
+		return Rectangle(min(p.x, q.x) - d, max(p.x, q.x) + d, min(p.y, q.y) - d, max(p.y, q.y) + d);
+	}
+
+	Rectangle TreeEdgeBox(int e) const
+	{
+		return BoundingBox(treeEdges[e].first->position, treeEdges[e].second->position, 0);
+	}
+
+	Point ClosestPoint(int e, const Point& p) const
+	{
+		return geometry::ClosestPoint(Segment(treeEdges[e].first->position, treeEdges[e].second->position), p);
+	}
+
+	//the node boundaries intersecting the range, in the order of hardObstacles
+	VI NearObstacles(const Rectangle& range) const
+	{
+		VI res;
+		obstacleGrid.query(range, [&](int i) { if (hardObstacles[i].Intersects(range)) res.push_back(i); });
+
+		sort(res.begin(), res.end());
+		res.erase(unique(res.begin(), res.end()), res.end());
+		return res;
 	}
 };
 
@@ -314,11 +413,18 @@ public:
 		//ink
 		cost += InkImportance * vg.Ink();
 
-        //hubs
+        //hubs (summed in the order of nodes)
 		vector<RoutingNode*> vNodes = vg.VirtualNodes();
+		VD radiusCost(vNodes.size());
+		#pragma omp parallel for schedule(dynamic)
 		for (int i = 0; i < (int)vNodes.size(); i++)
 		{
-			cost += RadiusCost(vg, vNodes[i], vNodes[i]->Position());
+			radiusCost[i] = RadiusCost(vg, vNodes[i], vNodes[i]->Position());
+		}
+
+		for (int i = 0; i < (int)vNodes.size(); i++)
+		{
+			cost += radiusCost[i];
         }
 
 		return cost;
@@ -330,7 +436,7 @@ public:
         //ink
         double oldInk = vg.Ink();
         double newInk = vg.Ink();
-		vector<RoutingNode*> neighbors = node->Neighbors();
+		const vector<RoutingNode*>& neighbors = node->Neighbors();
 		for (int i = 0; i < (int)neighbors.size(); i++)
 		{
 			RoutingNode* adj = neighbors[i];
@@ -343,10 +449,16 @@ public:
 
     /// Gain of radii
     static double RadiusGain(RoutingGraph& vg, RoutingNode* node, const Point& newPosition) 
+	{
+        return RadiusGain(vg, node, RadiusCost(vg, node, node->Position()), newPosition);
+    }
+
+    /// Gain of radii, given the cost at the current position
+    static double RadiusGain(RoutingGraph& vg, RoutingNode* node, double oldCost, const Point& newPosition) 
 	{
         double gain = 0;
 
-		gain += RadiusCost(vg, node, node->Position());
+		gain += oldCost;
         gain -= RadiusCost(vg, node, newPosition);
 
         return gain;
@@ -380,16 +492,15 @@ public:
     /// if a newPosition is not valid (e.g. intersect obstacles) the result is -inf
     static double BundleGain(RoutingGraph& vg, RoutingNode* node, const Point& newPosition)
 	{
-        double gain = 0;
+        return BundleGain(vg, node, BundleCost(vg, node), newPosition);
+    }
 
-		vector<RoutingNode*> neighbors = node->Neighbors();
-		for (int i = 0; i < (int)neighbors.size(); i++)
-		{
-			double lgain = BundleCost(vg, node, neighbors[i], node->Position());
-			assert(lgain < INF);
-			gain += lgain;
-        }
+    /// Gain of bundles, given the cost at the current position
+    static double BundleGain(RoutingGraph& vg, RoutingNode* node, double oldCost, const Point& newPosition)
+	{
+        double gain = oldCost;
 
+		const vector<RoutingNode*>& neighbors = node->Neighbors();
 		for (int i = 0; i < (int)neighbors.size(); i++)
 		{
             double lgain = BundleCost(vg, node, neighbors[i], newPosition);
@@ -400,6 +511,22 @@ public:
         return gain;
     }
 
+    /// Cost of the bundles of the node at its current position
+    static double BundleCost(RoutingGraph& vg, RoutingNode* node)
+	{
+        double cost = 0;
+
+		const vector<RoutingNode*>& neighbors = node->Neighbors();
+		for (int i = 0; i < (int)neighbors.size(); i++)
+		{
+			double lcost = BundleCost(vg, node, neighbors[i], node->Position());
+			assert(lcost < INF);
+			cost += lcost;
+        }
+
+        return cost;
+    }
+
     static double BundleCost(RoutingGraph& vg, RoutingNode* node, RoutingNode* adj, const Point& newPosition)
 	{
 		double idealWidth = RoutingNode::IdealHubWidth;
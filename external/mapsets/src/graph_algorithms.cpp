@@ -1,10 +1,18 @@
 #include "graph_algorithms.h"
+
+#include "profile/profile.h"
+
 #include <queue>
 #include <set>
 #include <cassert>
 
+static profile::Counter DijkstraRuns("shortest_path_runs");
+static profile::Counter SpanningTreeRuns("spanning_tree_runs");
+
 pair<VD, VI> GenericDijkstraMSTAlgorithm(const VI& nodes, const VVI& edges, const VVD& distances, int source, bool isDijkstra)
 {
+	(isDijkstra ? DijkstraRuns : SpanningTreeRuns).add();
+
 	VI used = VI(nodes.size(), 0);
 	VI parent = VI(nodes.size(), -1);
 	VD dist(nodes.size(), INF);
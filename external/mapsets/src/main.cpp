@@ -2,6 +2,8 @@
 #include "common/random_utils.h"
 #include "common/cmd_options.h"
 
+#include "profile/profile.h"
+
 #include "mapsets.h"
 
 void PrepareCMDOptions(int argc, char** argv, CMDOptions& args)
@@ -14,17 +16,38 @@ void PrepareCMDOptions(int argc, char** argv, CMDOptions& args)
 	args.AddAllowedOption("", "", "Input file name (stdin, if no input file is supplied)");
 	args.AddAllowedOption("-o", "", "Output file name (stdout, if no output file is supplied)");
 
+	args.AddAllowedOption("-visibility", "sparse", "Visibility graph for the trees: the closest points only or all visible pairs");
+	args.AddAllowedValue("-visibility", "sparse");
+	args.AddAllowedValue("-visibility", "full");
+
+	args.AddAllowedOption("-adjustment", "serial", "Force-directed adjustment of the trees: move the nodes one by one or at the same time (in parallel)");
+	args.AddAllowedValue("-adjustment", "serial");
+	args.AddAllowedValue("-adjustment", "parallel");
+
+	args.AddAllowedOption("-log", "none", "Print the energy and the time of every iteration of the adjustment to stderr");
+	args.AddAllowedValue("-log", "none");
+	args.AddAllowedValue("-log", "adjustment");
+
+	args.AddAllowedOption("--profile", "Write the wall time, the peak memory and the event counters of every stage to stderr as JSON");
+
 	args.Parse(argc, argv);
+
+	if (args.hasOption("--profile"))
+		profile::Enable();
 }
 
 DotGraph ReadGraph(const string& filename)
 {
-	DotReader parser;
+	profile::Stage stage("read");
+
+	DotReader parser(true);
 	return parser.ReadGraph(filename);
 }
 
 void WriteGraph(const string& filename, DotGraph& g)
 {
+	profile::Stage stage("write");
+
 	DotWriter writer;
 	writer.WriteGraph(filename, g);
 }
@@ -41,7 +64,10 @@ int main(int argc, char **argv)
 		PrepareCMDOptions(argc, argv, *options);
 
 		DotGraph graph = ReadGraph((*options).getOption(""));
-		mapsets::BuildTrees(graph);
+		mapsets::BuildTrees(graph, 
+			(*options).getOption("-visibility") == "full", 
+			(*options).getOption("-adjustment") == "parallel", 
+			(*options).getOption("-log") == "adjustment");
 		WriteGraph((*options).getOption("-o"), graph);
 	}
 	catch (int code)
@@ -49,5 +75,6 @@ int main(int argc, char **argv)
 		returnCode = code;		
 	}
 
+	profile::Report("mapsets", argc, argv);
 	return returnCode;
 }
@@ -5,9 +5,12 @@
 #include "common/graph/dot_parser.h"
 #include "common/geometry/segment.h"
 
+#include "spatial/kd_tree.h"
+
+#include "profile/profile.h"
+
 #include "graph_algorithms.h"
 #include "fd_adjustment.h"
-#include "closest_point.h"
 #include "visibility.h"
 #include "visibility_utils.h"
 #include "cest_2approx.h"
@@ -54,33 +57,12 @@ void AddDummyVerticesAlongTreeEdges(DotGraph& g, const map<string, SegmentSet*>&
 {
 	int DUMMY_VERTICES_CNT = 25;
 
-	ClosestPointQP cp(g.GetBoundingBox());
-	map<Point, string> point2Cluster;
 	map<string, string> cluster2ClusterColor;
 	for (int i = 0; i < (int)g.nodes.size(); i++)
 	{
 		if (g.nodes[i]->IsDummy()) continue;
 
-		Point p = g.nodes[i]->getPos();
-		string clusterId = g.nodes[i]->getCluster();
-		string clusterColor = g.nodes[i]->getClusterColor();
-		cp.addPoint(p);
-		point2Cluster[p] = clusterId;
-		cluster2ClusterColor[clusterId] = clusterColor;
-
-		vector<Segment> boundary = g.nodes[i]->getBoundary(1.0);
-		for (int j = 0; j < (int)boundary.size(); j++)
-		{
-			Segment s = boundary[j];
-			cp.addPoint(s.first);
-			point2Cluster[s.first] = clusterId;
-
-			cp.addPoint(s.second);
-			point2Cluster[s.second] = clusterId;
-
-			cp.addPoint(s.middle());
-			point2Cluster[s.middle()] = clusterId;
-		}
+		cluster2ClusterColor[g.nodes[i]->getCluster()] = g.nodes[i]->getClusterColor();
 	}
 
 	for (auto iter = trees.begin(); iter != trees.end(); iter++)
@@ -115,6 +97,30 @@ void AddDummyVerticesAlongTreeEdges(DotGraph& g, const map<string, SegmentSet*>&
 	}
 
 	return;
+
+	//the points of the nodes and their boundaries with the clusters
+	vector<Point> points;
+	VS pointClusters;
+	for (int i = 0; i < (int)g.nodes.size(); i++)
+	{
+		if (g.nodes[i]->IsDummy()) continue;
+
+		string clusterId = g.nodes[i]->getCluster();
+		points.push_back(g.nodes[i]->getPos());
+		pointClusters.push_back(clusterId);
+
+		vector<Segment> boundary = g.nodes[i]->getBoundary(1.0);
+		for (int j = 0; j < (int)boundary.size(); j++)
+		{
+			Segment s = boundary[j];
+			points.push_back(s.first);
+			points.push_back(s.second);
+			points.push_back(s.middle());
+			pointClusters.insert(pointClusters.end(), 3, clusterId);
+		}
+	}
+
+	spatial::KdTree cp(points);
 	for (auto iter = trees.begin(); iter != trees.end(); iter++)
 	{
 		string clusterId = (*iter).first;
@@ -135,12 +141,12 @@ void AddDummyVerticesAlongTreeEdges(DotGraph& g, const map<string, SegmentSet*>&
 				Point p = seg.first + delta * double(k + 1);
 
 				//do we need the point?
-				vector<Point> clp = cp.getKClosest(p, 5);
+				vector<spatial::Neighbor> clp;
+				cp.nearest(p.x, p.y, 5, clp);
 				bool needPoint = false;
 				for (int r = 0; r < (int)clp.size(); r++)
 				{
-					assert(point2Cluster.find(clp[r]) != point2Cluster.end());
-					string closestCluster = point2Cluster[clp[r]];
+					const string& closestCluster = pointClusters[clp[r].index];
 					if (closestCluster != clusterId) 
 					{
 						needPoint = true;
@@ -155,8 +161,8 @@ void AddDummyVerticesAlongTreeEdges(DotGraph& g, const map<string, SegmentSet*>&
 				p += Point::RandomPoint(-F, F, -F, F);
 				g.AddDummyPoint(p, clusterId, "");
 
-				cp.addPoint(p);
-				point2Cluster[p] = clusterId;
+				cp.add(p.x, p.y);
+				pointClusters.push_back(clusterId);
 			}
 		}
 	}
@@ -198,23 +204,36 @@ void AddDummyVerticesAlongLabels(DotGraph& g)
 	}
 }
 
-void BuildTrees(DotGraph& g)
+void BuildTrees(DotGraph& g, bool fullVisibility, bool parallelAdjustment, bool logAdjustment)
 {
 	// find spanning trees for each cluster
-	CEST2Approx vis2Approx;
-	auto trees = vis2Approx.BuildTrees(g);
+	map<string, SegmentSet*> trees;
+	{
+		profile::Stage stage("mapsets/cest2approx");
+		CEST2Approx vis2Approx(fullVisibility);
+		trees = vis2Approx.BuildTrees(g);
+	}
 
 	// pulling tree segments away from obstacles
-	ForceDirectedAdjustment(g, trees);
+	{
+		profile::Stage stage("mapsets/force_directed_adjustment");
+		ForceDirectedAdjustment(g, trees, parallelAdjustment, logAdjustment);
+	}
 
 	// adding as many non-intersecting inter-cluster edges as possible
 	//BuildSpanningSubgraphs(g, trees);
 
 	// adding dummy vertices for labels
-	AddDummyVerticesAlongLabels(g);
+	{
+		profile::Stage stage("mapsets/dummy_vertices_labels");
+		AddDummyVerticesAlongLabels(g);
+	}
 
 	// adding dummy vertices for tree edges
-	AddDummyVerticesAlongTreeEdges(g, trees);
+	{
+		profile::Stage stage("mapsets/dummy_vertices_tree_edges");
+		AddDummyVerticesAlongTreeEdges(g, trees);
+	}
 
 	Postprocessing(g);
 }
@@ -5,7 +5,10 @@
 
 namespace mapsets {
 
-void BuildTrees(DotGraph& g);
+//full visibility connects all visible pairs of points while building the trees (slower);
+//parallel adjustment moves the tree nodes at the same time (Jacobi-style) instead of one by one;
+//the energy of every iteration of the adjustment is printed to stderr if logAdjustment is set
+void BuildTrees(DotGraph& g, bool fullVisibility = false, bool parallelAdjustment = false, bool logAdjustment = false);
 
 } // namespace mapsets
 
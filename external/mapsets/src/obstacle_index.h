@@ -0,0 +1,154 @@
+#pragma once
+
+#include "common/common.h"
+#include "common/geometry/point.h"
+#include "common/geometry/segment.h"
+
+#include <unordered_map>
+#include <cassert>
+
+//Uniform grid over obstacles (segments) for crossing tests
+//
+//A segment is registered in every cell it passes through, widened by a small tolerance so
+//that touching segments are never missed. New segments are appended and the latest ones can
+//be removed, so the index is kept while some of the obstacles change (e.g., the trees of the
+//processed clusters stay and the boundaries of the nodes are replaced for every cluster)
+class ObstacleIndex
+{
+	ObstacleIndex(const ObstacleIndex&);
+	ObstacleIndex& operator = (const ObstacleIndex&);
+
+	double cellSize;
+	vector<Segment> segments;
+	unordered_map<long long, VI> cells;
+
+public:
+	ObstacleIndex(double cellSize): cellSize(cellSize)
+	{
+		assert(cellSize > 0);
+	}
+
+	int count() const
+	{
+		return (int)segments.size();
+	}
+
+	const Segment& get(int index) const
+	{
+		return segments[index];
+	}
+
+	const vector<Segment>& getSegments() const
+	{
+		return segments;
+	}
+
+	void append(const vector<Segment>& segs)
+	{
+		for (int i = 0; i < (int)segs.size(); i++)
+			append(segs[i]);
+	}
+
+	void append(const Segment& seg)
+	{
+		int index = (int)segments.size();
+		segments.push_back(seg);
+		ForEachCell(seg.first, seg.second, [&](long long cell) { cells[cell].push_back(index); });
+	}
+
+	//removes the segments appended after the first cnt ones
+	void truncate(int cnt)
+	{
+		assert(0 <= cnt && cnt <= count());
+		for (int index = count() - 1; index >= cnt; index--)
+		{
+			ForEachCell(segments[index].first, segments[index].second, [&](long long cell)
+			{
+				auto it = cells.find(cell);
+				assert(it != cells.end() && it->second.back() == index);
+				it->second.pop_back();
+				if (it->second.empty()) cells.erase(it);
+			});
+		}
+
+		segments.resize(cnt);
+	}
+
+	//calls test(index) for the segments that may intersect segment ab (a segment can be
+	//reported several times); returns true as soon as the test succeeds
+	template <class Test>
+	bool anyCandidate(const Point& a, const Point& b, Test test) const
+	{
+		bool found = false;
+		ForEachCell(a, b, [&](long long cell)
+		{
+			if (found) return;
+
+			auto it = cells.find(cell);
+			if (it == cells.end()) return;
+
+			const VI& cand = it->second;
+			for (int i = 0; i < (int)cand.size() && !found; i++)
+				if (test(cand[i])) found = true;
+		});
+
+		return found;
+	}
+
+	//cells of about twice the average obstacle length hold a few segments each
+	static double SuggestedCellSize(const vector<Segment>& segs)
+	{
+		double sum = 0;
+		for (int i = 0; i < (int)segs.size(); i++)
+			sum += segs[i].length();
+
+		if (sum < EPS) return 1.0;
+		return 2.0 * sum / (double)segs.size();
+	}
+
+private:
+	long long CellCoord(double x) const
+	{
+		return (long long)floor(x / cellSize);
+	}
+
+	static long long CellKey(long long cx, long long cy)
+	{
+		return (long long)(((unsigned long long)cx << 32) ^ (unsigned long long)(unsigned int)cy);
+	}
+
+	//the cells within a small distance from segment ab, column by column
+	template <class F>
+	void ForEachCell(const Point& a, const Point& b, F f) const
+	{
+		//covers the rounding errors and the tolerance of Segment::SegmentSegmentIntersect
+		double tol = 1e-6 * (cellSize + a.Distance(b));
+
+		Point p = a, q = b;
+		if (q.x < p.x) swap(p, q);
+		double dx = q.x - p.x;
+		double dy = q.y - p.y;
+
+		long long cx1 = CellCoord(q.x + tol);
+		for (long long cx = CellCoord(p.x - tol); cx <= cx1; cx++)
+		{
+			//the part of the segment inside the (widened) column
+			double xl = max(p.x, (double)cx * cellSize - tol);
+			double xr = min(q.x, (double)(cx + 1) * cellSize + tol);
+
+			double yl = min(p.y, q.y);
+			double yr = max(p.y, q.y);
+			if (dx > tol)
+			{
+				double y1 = p.y + dy * (xl - p.x) / dx;
+				double y2 = p.y + dy * (xr - p.x) / dx;
+				yl = min(y1, y2);
+				yr = max(y1, y2);
+			}
+
+			long long cy1 = CellCoord(yr + tol);
+			for (long long cy = CellCoord(yl - tol); cy <= cy1; cy++)
+				f(CellKey(cx, cy));
+		}
+	}
+};
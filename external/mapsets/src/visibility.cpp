@@ -1,22 +1,31 @@
 #include "common/geometry/geometry_utils.h"
-#include "common/geometry/rtree.h"
 
-#include "visibility.h"
-#include "graph_algorithms.h"
-#include "closest_point.h"
+#include "spatial/kd_tree.h"
 
-#include <memory>
+#include "profile/profile.h"
 
-typedef RNode<Segment> SegNode;
-typedef RTree<Segment> SegTree;
+#include "visibility.h"
+#include "visibility_sweep.h"
+#include "graph_algorithms.h"
 
-bool IsVisible(const VisibilityVertex& s, const VisibilityVertex& t, const SegTree& obstacleTree);
+bool ConesAllow(const VisibilityVertex& s, const VisibilityVertex& t);
 bool IsInCone(const VisibilityVertex& cone, const Point& p);
-bool Intersect(const VisibilityVertex& s, const VisibilityVertex& t, const Segment& seg);
+
+//the segments tested against the obstacles; the rotational sweeps (one per point)
+static profile::Counter VisibilityTests("visibility_tests");
+static profile::Counter VisibilitySweeps("visibility_sweeps");
 
 void VisibilityGraph::Initialze(const vector<Point>& p, const vector<Segment>& obstacles, bool fullVisibility)
 {
-	nodes = CreateVisibilityVertices(p, obstacles);
+	ObstacleIndex index(ObstacleIndex::SuggestedCellSize(obstacles));
+	index.append(obstacles);
+
+	Initialze(p, index, fullVisibility);
+}
+
+void VisibilityGraph::Initialze(const vector<Point>& p, const ObstacleIndex& obstacles, bool fullVisibility)
+{
+	nodes = CreateVisibilityVertices(p, obstacles.getSegments());
 	edges = CreateVisibilityEdges(nodes, obstacles, fullVisibility);
 }
 
@@ -29,7 +38,7 @@ struct ClockwiseComparator
 	{ 
 		return geometry::OrientationOf3Vectors(head - origin, p1 - origin, p2 - origin) <= 0;
 	}
-} comparator;
+};
 
 vector<VisibilityVertex> VisibilityGraph::CreateVisibilityVertices(const vector<Point>& p, const vector<Segment>& obstacles)
 {
@@ -58,6 +67,7 @@ vector<VisibilityVertex> VisibilityGraph::CreateVisibilityVertices(const vector<
 		assert(!adj.empty());
 
 		//sort clockwise
+		ClockwiseComparator comparator;
 		comparator.origin = p;
 		comparator.head = adj[0];
 		sort(adj.begin(), adj.end(), comparator);
@@ -87,9 +97,9 @@ Rectangle SegmentBoundingBox(const Segment& seg)
 }
 
 
-vector<vector<int> > VisibilityGraph::CreateVisibilityEdges(const vector<VisibilityVertex>& vis, const vector<Segment>& obstacles, bool fullVisibility)
+vector<vector<int> > VisibilityGraph::CreateVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles, bool fullVisibility)
 {
-	if (obstacles.empty())
+	if (obstacles.count() == 0)
 	{
 		vector<vector<int> > edges = VVI(vis.size(), VI());
 		for (int i = 0; i < (int)vis.size(); i++)
@@ -102,94 +112,190 @@ vector<vector<int> > VisibilityGraph::CreateVisibilityEdges(const vector<Visibil
 		return edges;
 	}
 
-	vector<SegNode*> nodes;
-	for (int i = 0; i < (int)obstacles.size(); i++)
+	if (fullVisibility)
+		return CreateFullVisibilityEdges(vis, obstacles);
+	else
+		return CreateSparseVisibilityEdges(vis, obstacles);
+}
+
+//groups the visibility vertices by their points (in the order of the first vertex)
+void GroupByPoint(const vector<VisibilityVertex>& vis, vector<Point>& points, VVI& pointVertices, map<Point, int>& pointIndex)
+{
+	for (int i = 0; i < (int)vis.size(); i++)
 	{
-		SegNode* node = new SegNode(SegmentBoundingBox(obstacles[i]), obstacles[i]);
-		nodes.push_back(node);
+		auto it = pointIndex.find(vis[i].p);
+		if (it == pointIndex.end())
+		{
+			it = pointIndex.insert(make_pair(vis[i].p, (int)points.size())).first;
+			points.push_back(vis[i].p);
+			pointVertices.push_back(VI());
+		}
+
+		pointVertices[(*it).second].push_back(i);
 	}
+}
 
-	auto obstacleTree = unique_ptr<SegTree>(new SegTree(nodes));
-	assert(obstacleTree->getRoot() != NULL);
+vector<vector<int> > VisibilityGraph::CreateFullVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles)
+{
+	vector<Point> points;
+	VVI pointVertices;
+	map<Point, int> pointIndex;
+	GroupByPoint(vis, points, pointVertices, pointIndex);
+
+	VisibilitySweep sweep(points, obstacles);
+	VisibilitySweeps.add(points.size());
+
+	//visible vertices j > i for every vertex i; one sweep per point
+	VVI rows = VVI(vis.size(), VI());
+	#pragma omp parallel for schedule(dynamic)
+	for (int p = 0; p < (int)points.size(); p++)
+	{
+		vector<char> blocked;
+		sweep.FindBlocked(p, blocked);
+
+		for (int k = 0; k < (int)pointVertices[p].size(); k++)
+		{
+			int i = pointVertices[p][k];
+			for (int q = 0; q < (int)points.size(); q++)
+			{
+				if (q == p || blocked[q]) continue;
+
+				const VI& adj = pointVertices[q];
+				for (int j = 0; j < (int)adj.size(); j++)
+					if (adj[j] > i && ConesAllow(vis[i], vis[adj[j]]))
+						rows[i].push_back(adj[j]);
+			}
+
+			sort(rows[i].begin(), rows[i].end());
+		}
+	}
 
 	vector<vector<int> > edges = VVI(vis.size(), VI());
+	for (int i = 0; i < (int)vis.size(); i++)
+		for (int j = 0; j < (int)rows[i].size(); j++)
+		{
+			edges[i].push_back(rows[i][j]);
+			edges[rows[i][j]].push_back(i);
+		}
 
-	if (fullVisibility)
+	return edges;
+}
+
+//at most k points closest to the p-th point of the tree (ordered by the distance and then by the
+//index) among the ones inside the square of half-side D*r around it, where r is the largest
+//0.1 * 2^i whose square contains no other point; the bound keeps the edges local around isolated
+//points (and the squares keep the output of the former quadtree search);
+//knn are the k points closest to the p-th one, except itself
+void FindClosestPoints(const spatial::KdTree& tree, int p, const vector<spatial::Neighbor>& knn, int k, double D, VI& result)
+{
+	result.clear();
+	if (knn.empty()) return;
+
+	double cx = tree.x(p), cy = tree.y(p);
+	auto inSquare = [&](int q, double r)
 	{
-		//full visibility
-		for (int i = 0; i < (int)vis.size(); i++)
-			for (int j = i + 1; j < (int)vis.size(); j++)
-				if (IsVisible(vis[i], vis[j], *obstacleTree)) 
-				{
-					edges[i].push_back(j);
-					edges[j].push_back(i);
-				}
-	}
-	else
+		return spatial::Box(cx - r, cx + r, cy - r, cy + r).contains(tree.x(q), tree.y(q));
+	};
+
+	//the points of the smallest squares with another point are within twice the closest distance
+	vector<spatial::Neighbor> near;
+	tree.withinRadius(cx, cy, 2 * knn[0].dist, near);
+	auto containsOther = [&](double r)
 	{
-		//sparse visibility
-		vector<int> adj;
-		Rectangle bb;
-		for (int i = 0; i < (int)vis.size(); i++)
+		for (int i = 0; i < (int)near.size(); i++)
+			if (near[i].index != p && inSquare(near[i].index, r)) return true;
+		return false;
+	};
+
+	double r = 0.1;
+	while (!containsOther(r))
+		r *= 2.0;
+	r /= 2.0;
+
+	//the k closest points, unless some of them are outside the square; then the points of the
+	//disk around the square
+	double bound = D * r;
+	near = knn;
+	for (int i = 0; i < (int)near.size(); i++)
+		if (!inSquare(near[i].index, bound))
 		{
-			adj.push_back(i);
-			bb.Add(vis[i].p);
+			tree.withinRadius(cx, cy, 1.5 * bound, near);
+			break;
 		}
 
-		ClosestPointQP cp(bb);
-		map<Point, vector<int> > point2VV;
-		for (int i = 0; i < (int)vis.size(); i++)
-		{
-			if (point2VV.find(vis[i].p) == point2VV.end())
-				cp.addPoint(vis[i].p);
+	for (int i = 0; i < (int)near.size() && (int)result.size() < k; i++)
+		if (near[i].index != p && inSquare(near[i].index, bound))
+			result.push_back(near[i].index);
+}
 
-			point2VV[vis[i].p].push_back(i);
-		}
+vector<vector<int> > VisibilityGraph::CreateSparseVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles)
+{
+	vector<Point> points;
+	VVI pointVertices;
+	map<Point, int> pointIndex;
+	GroupByPoint(vis, points, pointVertices, pointIndex);
+
+	//the tree holds the points in their order, so its ties (broken by index) follow the points
+	VI order, rank(points.size());
+	vector<Point> sortedPoints;
+	for (auto it = pointIndex.begin(); it != pointIndex.end(); it++)
+	{
+		rank[(*it).second] = (int)order.size();
+		order.push_back((*it).second);
+		sortedPoints.push_back((*it).first);
+	}
+	spatial::KdTree tree(sortedPoints);
 
-		int maxAdj = 30;
-		for (int i = 0; i < (int)vis.size(); i++)
+	//the closest points of all points at once
+	int maxAdj = 30;
+	vector<vector<spatial::Neighbor> > knn;
+	tree.nearestBatch(maxAdj, knn);
+
+	//the vertices at the closest points; the points are processed in parallel
+	vector<vector<int> > edges = VVI(vis.size(), VI());
+	#pragma omp parallel for schedule(dynamic)
+	for (int p = 0; p < (int)points.size(); p++)
+	{
+		VI closest;
+		FindClosestPoints(tree, rank[p], knn[rank[p]], maxAdj, 64, closest);
+		for (int k = 0; k < (int)closest.size(); k++)
+			closest[k] = order[closest[k]];
+
+		for (int k = 0; k < (int)closest.size(); k++)
 		{
-			vector<Point> adjP = cp.getKClosest(vis[i].p, maxAdj, 64);
+			const Point& q = points[closest[k]];
+			const VI& adj = pointVertices[closest[k]];
 
-			for (int k = 0; k < (int)adjP.size(); k++)
+			//the crossings are the same for all vertices at the points
+			int blocked = -1;
+			for (int s = 0; s < (int)pointVertices[p].size(); s++)
 			{
-				vector<int>& adj = point2VV[adjP[k]];
+				int i = pointVertices[p][s];
 				for (int j = 0; j < (int)adj.size(); j++)
 				{
-					if (i == adj[j]) continue;
-					if (IsVisible(vis[i], vis[adj[j]], *obstacleTree)) 
+					if (i == adj[j] || !ConesAllow(vis[i], vis[adj[j]])) continue;
+
+					if (blocked == -1)
+						blocked = (points[p] == q || IsBlocked(points[p], q, obstacles));
+					if (!blocked)
 						edges[i].push_back(adj[j]);
 				}
 			}
 		}
 	}
-	
+
 	return edges;
 }
 
-bool IntersectRectangleWithRNode(SegNode* node, const Rectangle& rect, const VisibilityVertex& s, const VisibilityVertex& t)
+bool IsBlocked(const Point& s, const Point& t, const ObstacleIndex& obstacles)
 {
-	if (!node->getRectangle().Intersects(rect)) return false;
-
-	if (!node->IsLeaf()) 
-	{
-		return IntersectRectangleWithRNode(node->getLeft(), rect, s, t) || IntersectRectangleWithRNode(node->getRight(), rect, s, t);
-    }
-    else 
-	{
-		if (Intersect(s, t, node->getData())) return true;
-    }
-
-	return false;
+	VisibilityTests.add();
+	return obstacles.anyCandidate(s, t, [&](int index) { return Intersect(s, t, obstacles.get(index)); });
 }
 
-bool IsVisible(const VisibilityVertex& s, const VisibilityVertex& t, const SegTree& obstacleTree)
+//the rules for the vertices at the corners of obstacles
+bool ConesAllow(const VisibilityVertex& s, const VisibilityVertex& t)
 {
-	if (s.p == t.p) return false;
-
-	//check crossings with obstacles
-	if (IntersectRectangleWithRNode(obstacleTree.getRoot(), SegmentBoundingBox(Segment(s.p, t.p)), s, t)) return false;
-
 	if (!s.real && !t.real)
 	{
 		if (s.leftP == t.p && t.rightP == s.p) return true;
@@ -212,12 +318,12 @@ bool IsInCone(const VisibilityVertex& cone, const Point& p)
 	return true;
 }
 
-bool Intersect(const VisibilityVertex& s, const VisibilityVertex& t, const Segment& seg)
+bool Intersect(const Point& s, const Point& t, const Segment& seg)
 {
-	if (s.p == seg.first || s.p == seg.second) return false;
-	if (t.p == seg.first || t.p == seg.second) return false;
+	if (s == seg.first || s == seg.second) return false;
+	if (t == seg.first || t == seg.second) return false;
 
-	if (Segment::SegmentSegmentIntersect(s.p, t.p, seg.first, seg.second)) return true;
+	if (Segment::SegmentSegmentIntersect(s, t, seg.first, seg.second)) return true;
 
 	return false;
 }
@@ -6,6 +6,7 @@
 #include "common/graph/dot_graph.h"
 
 #include "segment_set.h"
+#include "obstacle_index.h"
 
 struct VisibilityVertex
 {
@@ -26,8 +27,11 @@ private:
 	VisibilityGraph& operator = (const VisibilityGraph&);
 
 	void Initialze(const vector<Point>& points, const vector<Segment>& obstacles, bool fullVisibility);
+	void Initialze(const vector<Point>& points, const ObstacleIndex& obstacles, bool fullVisibility);
 	vector<VisibilityVertex> CreateVisibilityVertices(const vector<Point>& p, const vector<Segment>& obstacles);
-	vector<vector<int> > CreateVisibilityEdges(const vector<VisibilityVertex>& vis, const vector<Segment>& obstacles, bool fullVisibility);
+	vector<vector<int> > CreateVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles, bool fullVisibility);
+	vector<vector<int> > CreateSparseVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles);
+	vector<vector<int> > CreateFullVisibilityEdges(const vector<VisibilityVertex>& vis, const ObstacleIndex& obstacles);
 
 public:
 	vector<VisibilityVertex> nodes;
@@ -44,9 +48,20 @@ public:
 		Initialze(points, obstacles, fullVisibility);
 	}
 
+	//full visibility connects all pairs of visible vertices (by a rotational sweep),
+	//sparse visibility only the vertices at a few closest points
+	VisibilityGraph(const vector<Point>& points, const ObstacleIndex& obstacles, bool fullVisibility) 
+	{
+		Initialze(points, obstacles, fullVisibility);
+	}
+
 };
 
 
+//does segment st cross an obstacle? (the obstacles incident to s or t are ignored)
+bool IsBlocked(const Point& s, const Point& t, const ObstacleIndex& obstacles);
+bool Intersect(const Point& s, const Point& t, const Segment& seg);
+
 class CESTAlgorithm
 {
 public:
@@ -0,0 +1,311 @@
+#include "common/geometry/geometry_utils.h"
+
+#include "visibility_sweep.h"
+#include "visibility.h"
+
+#include <algorithm>
+
+double Cross(const Point& a, const Point& b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+//the crossing of the ray from the source with the line of segment ab, in the units of the ray
+double RayHit(const Point& source, const Point& ray, const Point& a, const Point& b)
+{
+	Point ab = b - a;
+	return Cross(a - source, ab) / Cross(ray, ab);
+}
+
+VisibilitySweep::VisibilitySweep(const vector<Point>& points, const ObstacleIndex& obstacles): points(points), obstacles(obstacles)
+{
+	assert(!points.empty());
+
+	Rectangle bb(points[0]);
+	for (int i = 0; i < (int)points.size(); i++)
+		bb.Add(points[i]);
+	for (int i = 0; i < obstacles.count(); i++)
+	{
+		bb.Add(obstacles.get(i).first);
+		bb.Add(obstacles.get(i).second);
+	}
+	diameter = bb.minPoint().Distance(bb.maxPoint());
+
+	SplitObstacles();
+}
+
+void VisibilitySweep::SplitObstacles()
+{
+	map<Point, int> pointIndex;
+	for (int i = 0; i < (int)points.size(); i++)
+		pointIndex[points[i]] = i;
+
+	auto indexOf = [&](const Point& p)
+	{
+		auto it = pointIndex.find(p);
+		return (it != pointIndex.end() ? (*it).second : -1);
+	};
+
+	for (int i = 0; i < obstacles.count(); i++)
+	{
+		const Segment& seg = obstacles.get(i);
+		Point dir = seg.second - seg.first;
+
+		//the crossings with the other obstacles
+		VD cuts;
+		obstacles.anyCandidate(seg.first, seg.second, [&](int j)
+		{
+			if (j == i) return false;
+
+			const Segment& other = obstacles.get(j);
+			Point otherDir = other.second - other.first;
+			double den = Cross(dir, otherDir);
+			if (Abs(den) <= 1e-12 * seg.length() * other.length()) return false;
+
+			double u = Cross(other.first - seg.first, otherDir) / den;
+			double v = Cross(other.first - seg.first, dir) / den;
+			if (u > 0 && u < 1 && v > 0 && v < 1)
+				cuts.push_back(u);
+
+			return false;
+		});
+
+		sort(cuts.begin(), cuts.end());
+		cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+
+		Piece piece;
+		piece.obstacle = i;
+		piece.a = seg.first;
+		piece.pointA = indexOf(seg.first);
+		for (int k = 0; k < (int)cuts.size(); k++)
+		{
+			Point cut = seg.first + dir * cuts[k];
+			piece.b = cut;
+			piece.pointB = -1;
+			pieces.push_back(piece);
+
+			piece.a = cut;
+			piece.pointA = -1;
+		}
+
+		piece.b = seg.second;
+		piece.pointB = indexOf(seg.second);
+		pieces.push_back(piece);
+	}
+}
+
+void VisibilitySweep::FindBlockedDirectly(int source, vector<char>& blocked) const
+{
+	for (int q = 0; q < (int)points.size(); q++)
+		blocked[q] = (q != source && IsBlocked(points[source], points[q], obstacles));
+}
+
+//a monotone substitute of the polar angle in [0, 4), growing counterclockwise from the
+//direction (1, 0); its difference never exceeds the difference of the angles
+double PseudoAngle(const Point& d)
+{
+	if (d.y >= 0)
+		return (d.x >= 0 ? d.y / (d.x + d.y) : 1 - d.x / (d.y - d.x));
+	else
+		return (d.x < 0 ? 2 - d.y / (-d.x - d.y) : 3 + d.x / (d.x - d.y));
+}
+
+struct SweepEvent
+{
+	double angle;
+	//removals go before queries and insertions after them
+	int type;
+	int id;
+
+	//the directions within the window of an endpoint are degenerate (except for the point at the endpoint)
+	double window;
+	int point;
+
+	SweepEvent(double angle, int type, int id, double window, int point): angle(angle), type(type), id(id), window(window), point(point) {}
+
+	bool operator < (const SweepEvent& e) const
+	{
+		if (angle != e.angle) return angle < e.angle;
+		if (type != e.type) return type < e.type;
+		return id < e.id;
+	}
+};
+
+void VisibilitySweep::FindBlocked(int source, vector<char>& blocked) const
+{
+	const int REMOVE = 0, QUERY = 1, INSERT = 2, ENDPOINT = 3;
+
+	const Point& v = points[source];
+	blocked.assign(points.size(), 0);
+
+	//the obstacles incident to the source never block; an obstacle passing (almost)
+	//through the source makes every direction degenerate
+	double tol = 1e-6 * diameter;
+	vector<char> ignored(obstacles.count(), 0);
+	for (int i = 0; i < obstacles.count(); i++)
+	{
+		const Segment& seg = obstacles.get(i);
+		if (v == seg.first || v == seg.second)
+			ignored[i] = 1;
+		else if (geometry::ClosestPoint(seg, v).Distance(v) <= tol)
+		{
+			FindBlockedDirectly(source, blocked);
+			return;
+		}
+	}
+
+	//the pieces oriented counterclockwise around the source
+	vector<pair<Point, Point> > active;
+	VI activePiece;
+	vector<SweepEvent> events;
+	VI initial;
+	events.reserve(2 * pieces.size() + points.size());
+
+	//the window covers the tolerance of Segment::SegmentSegmentIntersect at the endpoint
+	double maxWindow = 0;
+	auto window = [&](const Point& d, double length)
+	{
+		double dist = d.Length();
+		double w = min(1.0, 1e-6 * (length + dist) / dist);
+		maxWindow = max(maxWindow, w);
+		return w;
+	};
+
+	for (int k = 0; k < (int)pieces.size(); k++)
+	{
+		const Piece& piece = pieces[k];
+		if (ignored[piece.obstacle]) continue;
+
+		double length = obstacles.get(piece.obstacle).length();
+		Point da = piece.a - v;
+		Point db = piece.b - v;
+		int pointA = piece.pointA;
+		int pointB = piece.pointB;
+
+		//a piece (almost) collinear with the source is within the windows of its endpoints
+		double cr = Cross(da, db);
+		if (Abs(cr) <= 1e-9 * da.Length() * db.Length())
+		{
+			events.push_back(SweepEvent(PseudoAngle(da), ENDPOINT, -1, window(da, length), pointA));
+			events.push_back(SweepEvent(PseudoAngle(db), ENDPOINT, -1, window(db, length), pointB));
+			continue;
+		}
+
+		if (cr < 0)
+		{
+			swap(da, db);
+			swap(pointA, pointB);
+		}
+
+		int id = (int)active.size();
+		active.push_back(make_pair(da + v, db + v));
+		activePiece.push_back(k);
+
+		double startAngle = PseudoAngle(da);
+		double endAngle = PseudoAngle(db);
+		events.push_back(SweepEvent(startAngle, INSERT, id, window(da, length), pointA));
+		events.push_back(SweepEvent(endAngle, REMOVE, id, window(db, length), pointB));
+		//crosses the initial ray
+		if (startAngle > endAngle) initial.push_back(id);
+	}
+
+	for (int q = 0; q < (int)points.size(); q++)
+	{
+		if (q == source) continue;
+
+		Point d = points[q] - v;
+		if (d.Length() <= tol)
+			blocked[q] = IsBlocked(v, points[q], obstacles);
+		else
+			events.push_back(SweepEvent(PseudoAngle(d), QUERY, q, 0, q));
+	}
+
+	sort(events.begin(), events.end());
+
+	//is there an endpoint (not at the point) whose window contains the direction of the k-th event?
+	int n = (int)events.size();
+	auto degenerate = [&](int k)
+	{
+		for (int dir = -1; dir <= 1; dir += 2)
+			for (int i = 1; i < n; i++)
+			{
+				const SweepEvent& e = events[(k + dir * i + n) % n];
+				double diff = Abs(e.angle - events[k].angle);
+				diff = min(diff, 4 - diff);
+				if (diff > maxWindow) break;
+
+				if (e.type != QUERY && e.point != events[k].point && diff <= e.window) return true;
+			}
+
+		return false;
+	};
+
+	//the pieces crossing the current ray ordered by the distance from the source
+	Point ray(1, 0);
+	auto closer = [&](int i, int j)
+	{
+		if (i == j) return false;
+
+		double hi = RayHit(v, ray, active[i].first, active[i].second);
+		double hj = RayHit(v, ray, active[j].first, active[j].second);
+		if (Abs(hi - hj) > 1e-9 * max(Abs(hi), Abs(hj))) return hi < hj;
+
+		//the pieces meet at the ray; compare them a bit further (before the first of them ends)
+		Point ei = active[i].second - v;
+		Point ej = active[j].second - v;
+		Point further = (Cross(ei, ej) >= 0 ? ei : ej);
+		further.Normalize();
+		Point dir = ray;
+		dir.Normalize();
+		further += dir;
+
+		hi = RayHit(v, further, active[i].first, active[i].second);
+		hj = RayHit(v, further, active[j].first, active[j].second);
+		if (Abs(hi - hj) > 1e-9 * max(Abs(hi), Abs(hj))) return hi < hj;
+
+		return i < j;
+	};
+
+	typedef set<int, decltype(closer)> Status;
+	Status status(closer);
+	vector<Status::iterator> position(active.size(), status.end());
+	for (int i = 0; i < (int)initial.size(); i++)
+		position[initial[i]] = status.insert(initial[i]).first;
+
+	for (int k = 0; k < (int)events.size(); k++)
+	{
+		const SweepEvent& e = events[k];
+		if (e.type == REMOVE)
+		{
+			status.erase(position[e.id]);
+			position[e.id] = status.end();
+		}
+		else if (e.type == INSERT)
+		{
+			ray = active[e.id].first - v;
+			position[e.id] = status.insert(e.id).first;
+		}
+		else if (e.type == QUERY)
+		{
+			const Point& t = points[e.id];
+			if (degenerate(k))
+			{
+				blocked[e.id] = IsBlocked(v, t, obstacles);
+				continue;
+			}
+
+			//the closest pieces crossing the segment to the point
+			ray = t - v;
+			for (auto it = status.begin(); it != status.end(); it++)
+			{
+				if (RayHit(v, ray, active[*it].first, active[*it].second) > 1.0 + 1e-6) break;
+
+				if (Intersect(v, t, obstacles.get(pieces[activePiece[*it]].obstacle)))
+				{
+					blocked[e.id] = 1;
+					break;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common/common.h"
+#include "common/geometry/point.h"
+#include "common/geometry/segment.h"
+
+#include "obstacle_index.h"
+
+//Rotational sweep (Lee's algorithm) finding the points visible from a given point
+//
+//The obstacles are split at their crossings, so that the pieces crossing a ray from the
+//source can be kept ordered by the distance along the ray. A ray is rotated around the
+//source; a point is blocked iff the closest pieces in its direction cross the segment
+//(tested by the same predicate as IsBlocked). The points in degenerate directions (close to
+//an endpoint of an obstacle) and the sources lying on obstacles are tested directly.
+//O((n + m) log (n + m)) per source for n points and m obstacles
+class VisibilitySweep
+{
+	VisibilitySweep(const VisibilitySweep&);
+	VisibilitySweep& operator = (const VisibilitySweep&);
+
+	struct Piece
+	{
+		Point a, b;
+		int obstacle;
+		//the indices of the points at the endpoints (-1 for crossings)
+		int pointA, pointB;
+	};
+
+	const vector<Point>& points;
+	const ObstacleIndex& obstacles;
+	vector<Piece> pieces;
+	//the diameter of the scene
+	double diameter;
+
+public:
+	//the points are distinct
+	VisibilitySweep(const vector<Point>& points, const ObstacleIndex& obstacles);
+
+	//blocked[q] = IsBlocked(points[source], points[q])
+	void FindBlocked(int source, vector<char>& blocked) const;
+
+private:
+	void SplitObstacles();
+	void FindBlockedDirectly(int source, vector<char>& blocked) const;
+};
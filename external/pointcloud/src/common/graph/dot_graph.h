@@ -4,6 +4,9 @@
 #include "common/geometry/point.h"
 #include "common/geometry/segment.h"
 #include "common/geometry/rectangle.h"
+#include "dotio/dot_reader.h"
+
+#include <unordered_map>
 
 class ConnectedDotGraph;
 
@@ -16,7 +19,7 @@ private:
 public:
 	int index;
 	string id;
-	map<string, string> attr;
+	dotio::Attributes attr;
 	Point pos;
 
 	DotNode(int index): index(index), pos(-1.0, -1.0) {};
@@ -25,59 +28,59 @@ public:
 	{
 		if (pos.x != -1 || pos.y != -1) return pos;
 
-		if (attr.find("pos") == attr.end())
+		if (!attr.has(dotio::KEY_POS))
 			cerr << "No attribute 'pos' for the node '" << id << "'\n";
 
-		char ch;
-		istringstream (getAttr("pos")) >> pos.x >> ch >> pos.y;
+		assert(attr.has(dotio::KEY_POS));
+		attr.getPoint(dotio::KEY_POS, pos.x, pos.y);
 		return pos;
 	}
 
 	string getCluster()
 	{
-		assert(hasAttr("cluster"));
-		return getAttr("cluster");
+		assert(attr.has(dotio::KEY_CLUSTER));
+		return attr.get(dotio::KEY_CLUSTER).str();
 	}
 
 	#define SCALE 52.0
 
 	double getWidth()
 	{
-		assert(hasAttr("width"));
-		return getDoubleAttr("width") * SCALE;
+		assert(attr.has(dotio::KEY_WIDTH));
+		return attr.getDouble(dotio::KEY_WIDTH) * SCALE;
 	}
 
 	double getHeight()
 	{
-		assert(hasAttr("height"));
-		return getDoubleAttr("height") * SCALE;
+		assert(attr.has(dotio::KEY_HEIGHT));
+		return attr.getDouble(dotio::KEY_HEIGHT) * SCALE;
 	}
 
 	string getAttr(const string& key)
 	{
-		assert(attr.find(key) != attr.end());
-		return attr[key];
+		assert(attr.has(key));
+		return attr.get(key).str();
 	}
 
 	void setAttr(const string& key, const string& value)
 	{
-		attr[key] = value;
+		attr.set(key, value);
 	}
 
 	bool hasAttr(const string& key)
 	{
-		return (attr.find(key) != attr.end());
+		return attr.has(key);
 	}
 
 	void removeAttr(const string& key)
 	{
-		if (attr.find(key) != attr.end())
-			attr.erase(attr.find(key));
+		attr.remove(key);
 	}
 
 	double getDoubleAttr(const string& key)
 	{
-		return toDouble(getAttr(key));
+		assert(attr.has(key));
+		return attr.getDouble(key);
 	}
 
 	vector<Segment> getBoundary(double marginCoef)
@@ -128,36 +131,37 @@ private:
 public:
 	int index;
 	string s, t;
-	map<string, string> attr;
+	dotio::Attributes attr;
 	double len;
 
 	DotEdge(int index): index(index), len(-1) {}
 
 	double getWeight()
 	{
-		if (attr.find("weight") == attr.end()) return 1.0;
-		return getDoubleAttr("weight");
+		if (!attr.has(dotio::KEY_WEIGHT)) return 1.0;
+		return attr.getDouble(dotio::KEY_WEIGHT);
 	}
 
 	double getLen()
 	{
 		if (len != -1) return len;
 
-		if (attr.find("len") == attr.end()) len = 1;
-		else len = getDoubleAttr("len");
+		if (!attr.has(dotio::KEY_LEN)) len = 1;
+		else len = attr.getDouble(dotio::KEY_LEN);
 
 		return len;
 	}
 
 	string getAttr(const string& key)
 	{
-		if (attr.find(key) == attr.end()) throw 1;
-		return attr[key];
+		if (!attr.has(key)) throw 1;
+		return attr.get(key).str();
 	}
 
 	double getDoubleAttr(const string& key)
 	{
-		return toDouble(getAttr(key));
+		if (!attr.has(key)) throw 1;
+		return attr.getDouble(key);
 	}
 };
 
@@ -170,6 +174,9 @@ class DotGraph
 public:
 	DotGraph(): initialized(false) {}
 
+	//input text viewed by the attributes of nodes and edges
+	shared_ptr<dotio::DotBuffer> buffer;
+
 	vector<DotNode*> style;
 
 	vector<DotNode*> nodes;
@@ -178,9 +185,16 @@ public:
 	map<string, vector<DotNode*> > clusters;
 	VVI adj;
 	VVI adjE;
-	map<pair<DotNode*, DotNode*>, DotEdge*> adjEdge;
+	struct NodePairHash
+	{
+		size_t operator () (const pair<DotNode*, DotNode*>& p) const
+		{
+			return hash<DotNode*>()(p.first) * 31 + hash<DotNode*>()(p.second);
+		}
+	};
+	unordered_map<pair<DotNode*, DotNode*>, DotEdge*, NodePairHash> adjEdge;
 
-	map<string, DotNode*> idToNode;
+	unordered_map<string, DotNode*> idToNode;
 	VI nodeDegree;
 	VD nodeWDegree;
 	map<pair<DotNode*, DotNode*>, int> shortestPaths;
@@ -196,7 +210,7 @@ public:
 
 		stringstream ss;
 		ss << pos.x << "," << pos.y;
-		nn->attr["pos"] = ss.str();
+		nn->setAttr("pos", ss.str());
 		nn->setAttr("cluster", clusterId);
 		nn->setAttr("height", "0.0");
 		nn->setAttr("width", "0.0");
@@ -218,7 +232,7 @@ public:
 			string c = toString(i + first + 1);
 			for (int j = 0; j < (int)clust[i].size(); j++)
 			{
-				clust[i][j]->attr["cluster"] = c;
+				clust[i][j]->setAttr("cluster", c);
 				clust[i][j]->removeAttr("clustercolor");
 			}
 		}
@@ -277,6 +291,7 @@ public:
 	{
 		if (idToNode.empty())
 		{
+			idToNode.reserve(nodes.size());
 			for (int i = 0; i < (int)nodes.size(); i++)
 				idToNode[nodes[i]->id] = nodes[i];
 		}
@@ -347,6 +362,7 @@ public:
 
 		adj = VVI(nodes.size(), VI());
 		adjE = VVI(nodes.size(), VI());
+		adjEdge.reserve(2 * edges.size());
 		for (int i = 0; i < (int)edges.size(); i++)
 		{
 			DotNode* s = findNodeById(edges[i]->s);
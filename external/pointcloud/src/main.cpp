@@ -2,10 +2,28 @@
 #include "common/graph/dot_graph.h"
 #include "common/graph/dot_parser.h"
 
-int main()
+#include "profile/profile.h"
+
+DotGraph ReadGraph()
 {
+	profile::Stage stage("read");
+
 	DotReader parser;
-	DotGraph g = parser.ReadGraph("");
+	return parser.ReadGraph("");
+}
+
+void WriteGraph(DotGraph& g)
+{
+	profile::Stage stage("write");
+
+	//empty attributes of the styles are omitted
+	DotWriter writer(false);
+	writer.WriteGraph("", g);
+}
+
+void ColorNodes(DotGraph& g)
+{
+	profile::Stage stage("pointcloud");
 
 	//remove background
 	for (int i = 0; i < (int)g.style.size(); i++)
@@ -41,8 +59,26 @@ int main()
 		string clr = g.nodes[i]->getAttr("clustercolor");
 		g.nodes[i]->setAttr("fillcolor", clr);
 	}
+}
 
-	DotWriter writer;
-	writer.WriteGraph("", g);
+int main(int argc, char** argv)
+{
+	//the only option: --profile writes the wall time and the peak memory of every stage to stderr as JSON
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) != "--profile")
+		{
+			fprintf(stderr, "unrecognized option \"%s\"\n", argv[i]);
+			return 1;
+		}
+
+		profile::Enable();
+	}
+
+	DotGraph g = ReadGraph();
+	ColorNodes(g);
+	WriteGraph(g);
+
+	profile::Report("pointcloud", argc, argv);
 	return 0;
 }
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace profile {
+
+// Profiling of the stages of a run
+//
+// A stage records its wall time, the peak resident memory of the process at its end and the
+// events counted while it was running. Nothing is recorded until Enable is called (--profile);
+// then Report writes all stages as one line of JSON to stderr. The stages may be nested; they
+// are reported in the order of their start. The counters are shared by all threads, so the
+// stages are meant to run one after another (the counts of concurrent stages would be mixed)
+
+class Counter;
+
+namespace detail {
+
+struct StageRecord
+{
+	std::string name;
+	double wall;
+	long peakRss;
+	std::vector<long long> counts;
+
+	StageRecord(): wall(0), peakRss(0) {}
+};
+
+struct State
+{
+	std::atomic<bool> enabled;
+	std::chrono::steady_clock::time_point start;
+	std::mutex mutex;
+	std::vector<Counter*> counters;
+	std::vector<StageRecord> stages;
+
+	State(): enabled(false) {}
+};
+
+inline State& state()
+{
+	static State s;
+	return s;
+}
+
+inline double Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void WriteString(FILE* f, const std::string& s)
+{
+	fputc('"', f);
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			fputc('\\', f);
+		if ((unsigned char)c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
+
+} // namespace detail
+
+inline bool Enabled()
+{
+	return detail::state().enabled.load(std::memory_order_relaxed);
+}
+
+inline void Enable()
+{
+	detail::state().start = std::chrono::steady_clock::now();
+	detail::state().enabled = true;
+}
+
+// the peak resident set size of the process in KB (0 if it is not available)
+inline long PeakRss()
+{
+#ifndef _WIN32
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#endif
+	return 0;
+}
+
+// A named counter of events (e.g. shortest path runs), defined as a static object next to the
+// code counting them. Hot loops should count locally and add the sums
+class Counter
+{
+	const char* name;
+	std::atomic<long long> value;
+
+	Counter(const Counter&);
+	Counter& operator = (const Counter&);
+
+public:
+	explicit Counter(const char* name): name(name), value(0)
+	{
+		std::lock_guard<std::mutex> lock(detail::state().mutex);
+		detail::state().counters.push_back(this);
+	}
+
+	void add(long long count = 1)
+	{
+		if (Enabled())
+			value.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	const char* getName() const
+	{
+		return name;
+	}
+
+	long long get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+};
+
+// A stage running from the construction to the destruction of the object
+class Stage
+{
+	int index;
+	std::chrono::steady_clock::time_point start;
+	std::vector<long long> startCounts;
+
+	Stage(const Stage&);
+	Stage& operator = (const Stage&);
+
+public:
+	explicit Stage(const std::string& name): index(-1)
+	{
+		if (!Enabled()) return;
+
+		detail::State& s = detail::state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		index = (int)s.stages.size();
+		s.stages.push_back(detail::StageRecord());
+		s.stages.back().name = name;
+		for (Counter* c : s.counters)
+			startCounts.push_back(c->get());
+		start = std::chrono::steady_clock::now();
+	}
+
+	~Stage()
+	{
+		if (index == -1) return;
+
+		double wall = detail::Seconds(start);
+		long peakRss = PeakRss();
+
+		detail::State& s = detail::state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		detail::StageRecord& record = s.stages[index];
+		record.wall = wall;
+		record.peakRss = peakRss;
+		for (int i = 0; i < (int)startCounts.size(); i++)
+			record.counts.push_back(s.counters[i]->get() - startCounts[i]);
+	}
+};
+
+// writes the stages and the totals of the counters to stderr, e.g.
+// {"tool":"kmeans","args":["-C=modularity","in.gv"],"wall_s":1.5,"peak_rss_kb":52000,
+//  "stages":[{"name":"read","wall_s":0.2,"peak_rss_kb":31000,"counters":{}}, ...],"counters":{"dijkstra_runs":0}}
+// (in one line); the counters of a stage are the nonzero ones
+inline void Report(const char* tool, int argc, char** argv)
+{
+	if (!Enabled()) return;
+
+	detail::State& s = detail::state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	FILE* f = stderr;
+
+	fprintf(f, "{\"tool\":");
+	detail::WriteString(f, tool);
+	fprintf(f, ",\"args\":[");
+	for (int i = 1; i < argc; i++)
+	{
+		if (i > 1) fputc(',', f);
+		detail::WriteString(f, argv[i]);
+	}
+	fprintf(f, "],\"wall_s\":%.6f,\"peak_rss_kb\":%ld,\"stages\":[", detail::Seconds(s.start), PeakRss());
+
+	for (int i = 0; i < (int)s.stages.size(); i++)
+	{
+		const detail::StageRecord& record = s.stages[i];
+		if (i > 0) fputc(',', f);
+		fprintf(f, "{\"name\":");
+		detail::WriteString(f, record.name);
+		fprintf(f, ",\"wall_s\":%.6f,\"peak_rss_kb\":%ld,\"counters\":{", record.wall, record.peakRss);
+
+		bool first = true;
+		for (int j = 0; j < (int)record.counts.size(); j++)
+		{
+			if (record.counts[j] == 0) continue;
+
+			if (!first) fputc(',', f);
+			first = false;
+			detail::WriteString(f, s.counters[j]->getName());
+			fprintf(f, ":%lld", record.counts[j]);
+		}
+		fprintf(f, "}}");
+	}
+
+	fprintf(f, "],\"counters\":{");
+	for (int i = 0; i < (int)s.counters.size(); i++)
+	{
+		if (i > 0) fputc(',', f);
+		detail::WriteString(f, s.counters[i]->getName());
+		fprintf(f, ":%lld", s.counters[i]->get());
+	}
+	fprintf(f, "}}\n");
+	fflush(f);
+}
+
+} // namespace profile
@@ -0,0 +1,170 @@
+// Compares the queries of spatial::KdTree with brute force on random points with many duplicates,
+// including the points added after the loading and the skipped point of nearest
+#include "spatial/kd_tree.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using spatial::Box;
+using spatial::KdTree;
+using spatial::Neighbor;
+
+namespace {
+
+int failures = 0;
+
+struct Query
+{
+	double x, y;
+
+	Query(double x, double y): x(x), y(y) {}
+};
+
+void check(bool condition, const char* query, int test, int query_index)
+{
+	if (condition) return;
+
+	failures++;
+	if (failures <= 10)
+		printf("FAILED: %s of query %d in test %d\n", query, query_index, test);
+}
+
+double distance(double x1, double y1, double x2, double y2)
+{
+	return std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+}
+
+std::vector<Neighbor> bruteNearest(const std::vector<double>& xs, const std::vector<double>& ys, double x, double y, int k, int skip)
+{
+	std::vector<Neighbor> all;
+	for (int i = 0; i < (int)xs.size(); i++)
+		if (i != skip) all.push_back(Neighbor(distance(x, y, xs[i], ys[i]), i));
+
+	std::sort(all.begin(), all.end());
+	if ((int)all.size() > k) all.erase(all.begin() + std::max(k, 0), all.end());
+	return all;
+}
+
+std::vector<Neighbor> bruteRadius(const std::vector<double>& xs, const std::vector<double>& ys, double x, double y, double r)
+{
+	std::vector<Neighbor> all;
+	for (int i = 0; i < (int)xs.size(); i++)
+	{
+		double d = distance(x, y, xs[i], ys[i]);
+		if (d <= r) all.push_back(Neighbor(d, i));
+	}
+
+	std::sort(all.begin(), all.end());
+	return all;
+}
+
+std::vector<int> bruteBox(const std::vector<double>& xs, const std::vector<double>& ys, const Box& box)
+{
+	std::vector<int> all;
+	for (int i = 0; i < (int)xs.size(); i++)
+		if (box.contains(xs[i], ys[i])) all.push_back(i);
+	return all;
+}
+
+bool same(const std::vector<Neighbor>& a, const std::vector<Neighbor>& b)
+{
+	if (a.size() != b.size()) return false;
+	for (int i = 0; i < (int)a.size(); i++)
+		if (a[i].index != b[i].index || a[i].dist != b[i].dist) return false;
+	return true;
+}
+
+// n points on a grid of the given size (so that many of them coincide), and added more after loading
+void runTest(int test, int n, int added, int grid, std::mt19937& rnd)
+{
+	std::uniform_int_distribution<int> coord(0, grid - 1);
+	std::vector<double> xs, ys;
+	for (int i = 0; i < n; i++)
+	{
+		xs.push_back(coord(rnd));
+		ys.push_back(coord(rnd));
+	}
+
+	KdTree tree(xs, ys);
+	for (int i = 0; i < added; i++)
+	{
+		xs.push_back(coord(rnd));
+		ys.push_back(coord(rnd));
+		tree.add(xs.back(), ys.back());
+	}
+
+	check(tree.size() == (int)xs.size(), "size", test, 0);
+	int total = (int)xs.size();
+	for (int i = 0; i < total; i++)
+		check(tree.x(i) == xs[i] && tree.y(i) == ys[i], "coordinates", test, i);
+
+	std::uniform_real_distribution<double> position(-1.0, grid);
+	std::vector<Neighbor> result;
+	std::vector<int> boxResult;
+	for (int q = 0; q < 200; q++)
+	{
+		// the queries at the points themselves hit the duplicates
+		double x = position(rnd), y = position(rnd);
+		int skip = -1;
+		if (q % 2 == 0 && total > 0)
+		{
+			skip = (int)(rnd() % total);
+			x = xs[skip];
+			y = ys[skip];
+		}
+
+		int k = (int)(rnd() % 12);
+		tree.nearest(x, y, k, result, skip);
+		check(same(result, bruteNearest(xs, ys, x, y, k, skip)), "nearest", test, q);
+
+		double r = position(rnd) / 4;
+		tree.withinRadius(x, y, r, result);
+		check(same(result, bruteRadius(xs, ys, x, y, r)), "withinRadius", test, q);
+
+		Box box(x - r, x + r / 2, y - r / 3, y + r);
+		tree.withinBox(box, boxResult);
+		check(boxResult == bruteBox(xs, ys, box), "withinBox", test, q);
+	}
+
+	std::vector<std::vector<Neighbor> > batch;
+	tree.nearestBatch(5, batch);
+	for (int i = 0; i < total; i++)
+		check(same(batch[i], bruteNearest(xs, ys, xs[i], ys[i], 5, i)), "nearestBatch", test, i);
+
+	// the points themselves as the queries, so that they find their duplicates
+	std::vector<Query> queries;
+	for (int i = 0; i < total; i++)
+		queries.push_back(Query(xs[i], ys[i]));
+	tree.nearestBatch(queries, 7, batch);
+	for (int i = 0; i < total; i++)
+		check(same(batch[i], bruteNearest(xs, ys, xs[i], ys[i], 7, -1)), "nearestBatch of queries", test, i);
+}
+
+}
+
+int main()
+{
+	std::mt19937 rnd(123);
+
+	int test = 0;
+	int sizes[] = {0, 1, 2, 7, 8, 9, 100, 1000, 5000};
+	for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		// few distinct positions (mostly duplicates) and many
+		runTest(test++, sizes[i], 0, 4, rnd);
+		runTest(test++, sizes[i], 0, 1000, rnd);
+		// the added points stay in the buffer or are merged into the tree
+		runTest(test++, sizes[i], 5, 10, rnd);
+		runTest(test++, sizes[i], sizes[i] + 50, 30, rnd);
+	}
+
+	if (failures > 0)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	printf("-- All kd-tree checks passed (%d tests) --\n", test);
+	return 0;
+}
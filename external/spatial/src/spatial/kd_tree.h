@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace spatial {
+
+// Axis-parallel rectangle [xl, xr] x [yl, yr]
+struct Box
+{
+	double xl, xr, yl, yr;
+
+	Box(): xl(0), xr(0), yl(0), yr(0) {}
+	Box(double xl, double xr, double yl, double yr): xl(xl), xr(xr), yl(yl), yr(yr) {}
+
+	bool contains(double x, double y) const
+	{
+		return xl <= x && x <= xr && yl <= y && y <= yr;
+	}
+
+	bool intersects(const Box& b) const
+	{
+		return !(xr < b.xl || b.xr < xl || yr < b.yl || b.yr < yl);
+	}
+
+	// a lower bound of the distance to the points inside (exact in floating point)
+	double distance(double x, double y) const
+	{
+		double dx = std::max(0.0, std::max(xl - x, x - xr));
+		double dy = std::max(0.0, std::max(yl - y, y - yr));
+		return std::sqrt(dx * dx + dy * dy);
+	}
+};
+
+// A point found by a query: its index (in the order of loading) and the distance to it
+struct Neighbor
+{
+	double dist;
+	int index;
+
+	Neighbor(double dist, int index): dist(dist), index(index) {}
+
+	// the order of the results: by distance, the ties are broken by index
+	bool operator < (const Neighbor& n) const
+	{
+		if (dist != n.dist) return dist < n.dist;
+		return index < n.index;
+	}
+};
+
+// Static kd-tree over points in the plane
+//
+// The points are bulk-loaded by recursive median splits across the wider side of the box,
+// until at most LeafSize points remain. The nodes with their boxes are kept in one array,
+// and the coordinates are reordered so that every leaf is a contiguous range. Points added
+// after the loading are kept in a small buffer, which is scanned by every query and merged
+// into the tree when it grows. The distances are sqrt(dx*dx + dy*dy), as for Point::Distance,
+// and the results do not depend on the shape of the tree. The queries do not modify the tree,
+// so they can be run concurrently (but not together with add)
+class KdTree
+{
+	static const int LeafSize = 8;
+
+	struct Node
+	{
+		Box box;
+		// the range of the points (in the tree order) of a leaf
+		int begin, end;
+		// the children of an inner node (-1 for leaves)
+		int left, right;
+	};
+
+	std::vector<Node> nodes;
+	// coordinates and indices of the points in the tree order
+	std::vector<double> xs, ys;
+	std::vector<int> ids;
+	// the position of every point in the tree order
+	std::vector<int> positions;
+	// the points added after the last loading
+	std::vector<double> extraXs, extraYs;
+
+public:
+	KdTree() {}
+
+	// points with fields x and y
+	template <class P>
+	explicit KdTree(const std::vector<P>& points)
+	{
+		std::vector<double> x(points.size()), y(points.size());
+		for (int i = 0; i < (int)points.size(); i++)
+		{
+			x[i] = points[i].x;
+			y[i] = points[i].y;
+		}
+
+		load(x, y);
+	}
+
+	KdTree(const std::vector<double>& x, const std::vector<double>& y)
+	{
+		load(x, y);
+	}
+
+	int size() const
+	{
+		return (int)(ids.size() + extraXs.size());
+	}
+
+	double x(int index) const
+	{
+		return (index < (int)ids.size() ? xs[positions[index]] : extraXs[index - ids.size()]);
+	}
+
+	double y(int index) const
+	{
+		return (index < (int)ids.size() ? ys[positions[index]] : extraYs[index - ids.size()]);
+	}
+
+	// adds a point with the next index
+	void add(double x, double y)
+	{
+		extraXs.push_back(x);
+		extraYs.push_back(y);
+
+		// keeps the cost of the scans of the buffer small compared to the queries in the tree
+		if ((int)extraXs.size() > std::max(4 * LeafSize, (int)ids.size() / 8))
+			reload();
+	}
+
+	// the k closest points (all points, if there are fewer), ordered by distance;
+	// the point with index skip (if any) is ignored
+	void nearest(double x, double y, int k, std::vector<Neighbor>& result, int skip = -1) const
+	{
+		result.clear();
+		if (k <= 0) return;
+
+		// a max-heap of the best points found so far
+		auto consider = [&](double px, double py, int index)
+		{
+			if (index == skip) return;
+
+			Neighbor n(dist(x, y, px, py), index);
+			if ((int)result.size() < k)
+			{
+				result.push_back(n);
+				std::push_heap(result.begin(), result.end());
+			}
+			else if (n < result.front())
+			{
+				std::pop_heap(result.begin(), result.end());
+				result.back() = n;
+				std::push_heap(result.begin(), result.end());
+			}
+		};
+
+		for (int i = 0; i < (int)extraXs.size(); i++)
+			consider(extraXs[i], extraYs[i], (int)ids.size() + i);
+
+		// best-first traversal; the nodes farther than the k-th point are skipped
+		// (but not the ones at the same distance, which may hold points with smaller indices)
+		auto pruned = [&](double d)
+		{
+			return (int)result.size() == k && d > result.front().dist;
+		};
+
+		std::vector<Neighbor> queue;
+		if (!nodes.empty()) queue.push_back(Neighbor(nodes[0].box.distance(x, y), 0));
+		while (!queue.empty())
+		{
+			std::pop_heap(queue.begin(), queue.end(), farther);
+			Neighbor cur = queue.back();
+			queue.pop_back();
+			if (pruned(cur.dist)) break;
+
+			const Node& node = nodes[cur.index];
+			if (node.left == -1)
+			{
+				for (int i = node.begin; i < node.end; i++)
+					consider(xs[i], ys[i], ids[i]);
+				continue;
+			}
+
+			int children[2] = {node.left, node.right};
+			for (int c = 0; c < 2; c++)
+			{
+				double d = nodes[children[c]].box.distance(x, y);
+				if (pruned(d)) continue;
+
+				queue.push_back(Neighbor(d, children[c]));
+				std::push_heap(queue.begin(), queue.end(), farther);
+			}
+		}
+
+		std::sort(result.begin(), result.end());
+	}
+
+	// the points within distance r (inclusive), ordered by distance
+	void withinRadius(double x, double y, double r, std::vector<Neighbor>& result) const
+	{
+		result.clear();
+
+		for (int i = 0; i < (int)extraXs.size(); i++)
+		{
+			double d = dist(x, y, extraXs[i], extraYs[i]);
+			if (d <= r) result.push_back(Neighbor(d, (int)ids.size() + i));
+		}
+
+		visit([&](const Box& box) { return box.distance(x, y) <= r; }, [&](int i)
+		{
+			double d = dist(x, y, xs[i], ys[i]);
+			if (d <= r) result.push_back(Neighbor(d, ids[i]));
+		});
+
+		std::sort(result.begin(), result.end());
+	}
+
+	// the points inside the box (including its boundary), ordered by index
+	void withinBox(const Box& range, std::vector<int>& result) const
+	{
+		result.clear();
+
+		for (int i = 0; i < (int)extraXs.size(); i++)
+			if (range.contains(extraXs[i], extraYs[i])) result.push_back((int)ids.size() + i);
+
+		visit([&](const Box& box) { return box.intersects(range); }, [&](int i)
+		{
+			if (range.contains(xs[i], ys[i])) result.push_back(ids[i]);
+		});
+
+		std::sort(result.begin(), result.end());
+	}
+
+	// result[i] = nearest(queries[i], k) for points with fields x and y; the queries are run in parallel
+	template <class P>
+	void nearestBatch(const std::vector<P>& queries, int k, std::vector<std::vector<Neighbor> >& result) const
+	{
+		result.assign(queries.size(), std::vector<Neighbor>());
+		#pragma omp parallel for schedule(dynamic, 64)
+		for (int i = 0; i < (int)queries.size(); i++)
+			nearest(queries[i].x, queries[i].y, k, result[i]);
+	}
+
+	// result[i] = the k closest points to the i-th point, except itself; the queries are run in parallel
+	void nearestBatch(int k, std::vector<std::vector<Neighbor> >& result) const
+	{
+		result.assign(size(), std::vector<Neighbor>());
+		#pragma omp parallel for schedule(dynamic, 64)
+		for (int i = 0; i < size(); i++)
+			nearest(x(i), y(i), k, result[i], i);
+	}
+
+private:
+	static double dist(double x1, double y1, double x2, double y2)
+	{
+		return std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+	}
+
+	// the order of the queue of nodes (a min-heap by distance)
+	static bool farther(const Neighbor& a, const Neighbor& b)
+	{
+		return b < a;
+	}
+
+	void load(const std::vector<double>& x, const std::vector<double>& y)
+	{
+		assert(x.size() == y.size());
+		int n = (int)x.size();
+
+		xs = x;
+		ys = y;
+		ids.resize(n);
+		for (int i = 0; i < n; i++)
+			ids[i] = i;
+
+		nodes.clear();
+		if (n > 0)
+		{
+			nodes.reserve(2 * (n / LeafSize + 1));
+			split(0, n);
+		}
+
+		// the coordinates in the tree order
+		positions.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			xs[i] = x[ids[i]];
+			ys[i] = y[ids[i]];
+			positions[ids[i]] = i;
+		}
+
+		extraXs.clear();
+		extraYs.clear();
+	}
+
+	void reload()
+	{
+		int n = size();
+		std::vector<double> x(n), y(n);
+		for (int i = 0; i < n; i++)
+		{
+			x[i] = this->x(i);
+			y[i] = this->y(i);
+		}
+
+		load(x, y);
+	}
+
+	// builds the subtree of the points ids[begin..end) (xs and ys are in the original order)
+	int split(int begin, int end)
+	{
+		Node node;
+		node.box = Box(xs[ids[begin]], xs[ids[begin]], ys[ids[begin]], ys[ids[begin]]);
+		for (int i = begin + 1; i < end; i++)
+		{
+			node.box.xl = std::min(node.box.xl, xs[ids[i]]);
+			node.box.xr = std::max(node.box.xr, xs[ids[i]]);
+			node.box.yl = std::min(node.box.yl, ys[ids[i]]);
+			node.box.yr = std::max(node.box.yr, ys[ids[i]]);
+		}
+		node.begin = begin;
+		node.end = end;
+		node.left = node.right = -1;
+
+		int index = (int)nodes.size();
+		nodes.push_back(node);
+		if (end - begin <= LeafSize) return index;
+
+		const std::vector<double>& coord = (node.box.xr - node.box.xl >= node.box.yr - node.box.yl ? xs : ys);
+		int mid = (begin + end) / 2;
+		std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end, [&](int a, int b)
+		{
+			if (coord[a] != coord[b]) return coord[a] < coord[b];
+			return a < b;
+		});
+
+		int left = split(begin, mid);
+		int right = split(mid, end);
+		nodes[index].left = left;
+		nodes[index].right = right;
+		return index;
+	}
+
+	// calls report(i) for the points (in the tree order) of the leaves whose boxes pass the test
+	template <class Test, class Report>
+	void visit(Test test, Report report) const
+	{
+		if (nodes.empty()) return;
+
+		int stack[128];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node& node = nodes[stack[--top]];
+			if (!test(node.box)) continue;
+
+			if (node.left == -1)
+			{
+				for (int i = node.begin; i < node.end; i++)
+					report(i);
+			}
+			else
+			{
+				assert(top + 2 <= 128);
+				stack[top++] = node.right;
+				stack[top++] = node.left;
+			}
+		}
+	}
+};
+
+} // namespace spatial
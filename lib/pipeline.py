@@ -58,6 +58,19 @@ def mapsets_post_command(color_scheme):
 
 def pointcloud_command():
     return CURPATH + "/external/pointcloud/pointcloud"
+
+def engine_command():
+    return CURPATH + "/external/engine/engine"
+
+# clustering algorithms of kmeans (the ones not followed by ceba)
+KMEANS_ALGORITHMS = {
+	'k-means': 'graphkmeans',
+	'cont-k-means': 'geometrickmeans',
+	'hierarchical': 'graphhierarchical',
+	'cont-hierarchical': 'modularity-cont',
+	'infomap': 'infomap',
+	'modularity': 'modularity',
+}
     
 
 def removeNonAscii(s): return "".join(i for i in s if ord(i)<128)
@@ -73,6 +86,82 @@ def call_process(gv_command, map_string, raw_output = False):
 		return dot_out
 	return removeNonAscii(dot_out)
 
+class EngineClient:
+	"""Runs jobs on a long-lived engine process (external/engine) instead of starting
+	kmeans, mapsets and pointcloud for every request; the process is started on the first
+	job and again after it stops"""
+
+	def __init__(self):
+		self.lock = threading.Lock()
+		self.proc = None
+		self.pending = {}
+		self.last_id = 0
+
+	def run(self, options, map_string):
+		data = removeNonAscii(map_string)
+		job = {'done': threading.Event(), 'ok': False, 'output': 'the engine has stopped'}
+		with self.lock:
+			if self.proc is None:
+				self.start()
+			self.last_id += 1
+			job_id = str(self.last_id)
+			job['proc'] = self.proc
+			self.pending[job_id] = job
+			try:
+				self.proc.stdin.write("%s %d %s\n" % (job_id, len(data), options))
+				self.proc.stdin.write(data)
+				self.proc.stdin.flush()
+			except IOError:
+				del self.pending[job_id]
+				raise CallExternalException(job['output'])
+
+		job['done'].wait()
+		if not job['ok']:
+			raise CallExternalException(job['output'])
+		return removeNonAscii(job['output'])
+
+	def start(self):
+		self.proc = Popen([engine_command(), '-serve=stdio'], stdout=PIPE, stdin=PIPE)
+		reader = threading.Thread(target=self.dispatch, args=(self.proc,))
+		reader.daemon = True
+		reader.start()
+
+	def dispatch(self, proc):
+		# responses come in the order of completion
+		while True:
+			header = proc.stdout.readline().split()
+			if len(header) != 3:
+				break
+			job_id, status, length = header
+			output = proc.stdout.read(int(length))
+			with self.lock:
+				job = self.pending.pop(job_id, None)
+			if job:
+				job['ok'] = (status == 'ok')
+				job['output'] = output
+				job['done'].set()
+
+		# the engine has stopped; fail its jobs in progress
+		proc.wait()
+		with self.lock:
+			if self.proc is proc:
+				self.proc = None
+			for job_id, job in self.pending.items():
+				if job['proc'] is proc:
+					del self.pending[job_id]
+					job['done'].set()
+
+ENGINE = EngineClient()
+
+def call_engine(options, map_string, command):
+	"""runs the stages on the engine or, if it is not built, the command of the separate tool"""
+	if not os.path.exists(engine_command()):
+		return call_process(command, map_string)
+	return ENGINE.run(options, map_string)
+
+def run_kmeans(alg, dot_out):
+	return call_engine('-stages=clustering -C=%s' % (alg), dot_out, cluster_command(alg))
+
 def call_graphviz(task):
 	try:
 		return call_graphviz_int(task)
@@ -96,23 +185,23 @@ def run_clustering(task, cluster_algorithm, dot_out):
 
 	set_status(task, 'running clustering')
 	if cluster_algorithm == 'k-means':
-		return call_process(cluster_command('graphkmeans'), dot_out)
+		return run_kmeans('graphkmeans', dot_out)
 	elif cluster_algorithm == 'cont-k-means':
-		return call_process(cluster_command('geometrickmeans'), dot_out)
+		return run_kmeans('geometrickmeans', dot_out)
 	elif cluster_algorithm == 'hierarchical':
-		return call_process(cluster_command('graphhierarchical'), dot_out)
+		return run_kmeans('graphhierarchical', dot_out)
 	elif cluster_algorithm == 'cont-hierarchical':
-		return call_process(cluster_command('modularity-cont'), dot_out)
+		return run_kmeans('modularity-cont', dot_out)
 	elif cluster_algorithm == 'infomap':
-		return call_process(cluster_command('infomap'), dot_out)
+		return run_kmeans('infomap', dot_out)
 	elif cluster_algorithm == 'cont-infomap':
-		dot_out = call_process(cluster_command('infomap'), dot_out)
+		dot_out = run_kmeans('infomap', dot_out)
 		set_status(task, 'making map contiguous')
 		return call_process(ceba_command(), dot_out)
 	elif cluster_algorithm == 'modularity':
-		return call_process(cluster_command('modularity'), dot_out)
+		return run_kmeans('modularity', dot_out)
 	elif cluster_algorithm == 'cont-modularity':
-		dot_out = call_process(cluster_command('modularity'), dot_out)
+		dot_out = run_kmeans('modularity', dot_out)
 		set_status(task, 'making map contiguous')
 		return call_process(ceba_command(), dot_out)
 
@@ -152,7 +241,7 @@ def call_graphviz_int(task):
     		dot_out = run_color_assignment(task, dot_out)
 
     	set_status(task, 'point cloud construction')
-    	dot_out = call_process(pointcloud_command(), dot_out)
+    	dot_out = call_engine('-stages=pointcloud', dot_out, pointcloud_command())
 
     	svg_out = get_graphviz_map(dot_out, 'svg')
     	return dot_out, svg_out
@@ -185,15 +274,20 @@ def call_graphviz_int(task):
 
     elif vis_type == 'map-sets':
     	dot_out = run_layout(task, layout_algorithm, map_string)
-    	dot_out = run_clustering(task, cluster_algorithm, dot_out)
-    	# running ceba
-    	#if not cluster_algorithm.startswith('cont-'):
-    	#	set_status(task, 'making map contiguous')
-    	#	dot_out = call_process(ceba_command(), dot_out)
-
-    	set_status(task, 'creating map sets')
-    	#log.debug('MapSets-Input: %s' %(dot_out))
-    	dot_out = call_process(mapsets_command(), dot_out)
+    	if cluster_algorithm in KMEANS_ALGORITHMS and os.path.exists(engine_command()):
+    		#clustering and map sets in a single job
+    		set_status(task, 'running clustering and creating map sets')
+    		dot_out = ENGINE.run('-stages=clustering,mapsets -C=%s' % (KMEANS_ALGORITHMS[cluster_algorithm]), dot_out)
+    	else:
+    		dot_out = run_clustering(task, cluster_algorithm, dot_out)
+    		# running ceba
+    		#if not cluster_algorithm.startswith('cont-'):
+    		#	set_status(task, 'making map contiguous')
+    		#	dot_out = call_process(ceba_command(), dot_out)
+
+    		set_status(task, 'creating map sets')
+    		#log.debug('MapSets-Input: %s' %(dot_out))
+    		dot_out = call_engine('-stages=mapsets', dot_out, mapsets_command())
     	dot_out = call_process(mapsets_post_command(task.color_scheme), dot_out)
     	if task.color_scheme == 'bubble-sets':
     		dot_out = run_color_assignment(task, dot_out)